@@ -0,0 +1,328 @@
+/*************************************************************************/
+/*  bytecode_77dcf97.cpp                                                 */
+/*************************************************************************/
+
+#include "bytecode_77dcf97.h"
+
+#include "core/io/compression.h"
+#include "core/io/marshalls.h"
+
+const GDScriptDecomp::GlobalToken GDScriptDecomp_77dcf97::token_table[] = {
+	G_TK_EMPTY,
+	G_TK_ANNOTATION,
+	G_TK_IDENTIFIER,
+	G_TK_CONSTANT, // LITERAL
+	G_TK_OP_LESS,
+	G_TK_OP_LESS_EQUAL,
+	G_TK_OP_GREATER,
+	G_TK_OP_GREATER_EQUAL,
+	G_TK_OP_EQUAL,
+	G_TK_OP_NOT_EQUAL,
+	G_TK_OP_AND,
+	G_TK_OP_OR,
+	G_TK_OP_NOT,
+	G_TK_OP_AND, // AMPERSAND_AMPERSAND
+	G_TK_OP_OR, // PIPE_PIPE
+	G_TK_OP_NOT, // BANG
+	G_TK_OP_BIT_AND,
+	G_TK_OP_BIT_OR,
+	G_TK_OP_BIT_INVERT,
+	G_TK_OP_BIT_XOR,
+	G_TK_OP_SHIFT_LEFT,
+	G_TK_OP_SHIFT_RIGHT,
+	G_TK_OP_ADD,
+	G_TK_OP_SUB,
+	G_TK_OP_MUL,
+	G_TK_OP_POW,
+	G_TK_OP_DIV,
+	G_TK_OP_MOD,
+	G_TK_OP_ASSIGN,
+	G_TK_OP_ASSIGN_ADD,
+	G_TK_OP_ASSIGN_SUB,
+	G_TK_OP_ASSIGN_MUL,
+	G_TK_OP_ASSIGN_POW,
+	G_TK_OP_ASSIGN_DIV,
+	G_TK_OP_ASSIGN_MOD,
+	G_TK_OP_ASSIGN_SHIFT_LEFT,
+	G_TK_OP_ASSIGN_SHIFT_RIGHT,
+	G_TK_OP_ASSIGN_BIT_AND,
+	G_TK_OP_ASSIGN_BIT_OR,
+	G_TK_OP_ASSIGN_BIT_XOR,
+	G_TK_CF_IF,
+	G_TK_CF_ELIF,
+	G_TK_CF_ELSE,
+	G_TK_CF_FOR,
+	G_TK_CF_WHILE,
+	G_TK_CF_BREAK,
+	G_TK_CF_CONTINUE,
+	G_TK_CF_PASS,
+	G_TK_CF_RETURN,
+	G_TK_CF_MATCH,
+	G_TK_CF_WHEN,
+	G_TK_PR_AS,
+	G_TK_PR_ASSERT,
+	G_TK_PR_AWAIT,
+	G_TK_PR_BREAKPOINT,
+	G_TK_PR_CLASS,
+	G_TK_PR_CLASS_NAME,
+	G_TK_PR_CONST,
+	G_TK_PR_ENUM,
+	G_TK_PR_EXTENDS,
+	G_TK_PR_FUNCTION,
+	G_TK_OP_IN,
+	G_TK_PR_IS,
+	G_TK_PR_NAMESPACE,
+	G_TK_PR_PRELOAD,
+	G_TK_SELF,
+	G_TK_PR_SIGNAL,
+	G_TK_PR_STATIC,
+	G_TK_PR_SUPER,
+	G_TK_PR_TRAIT,
+	G_TK_PR_VAR,
+	G_TK_PR_VOID,
+	G_TK_PR_YIELD,
+	G_TK_BRACKET_OPEN,
+	G_TK_BRACKET_CLOSE,
+	G_TK_CURLY_BRACKET_OPEN,
+	G_TK_CURLY_BRACKET_CLOSE,
+	G_TK_PARENTHESIS_OPEN,
+	G_TK_PARENTHESIS_CLOSE,
+	G_TK_COMMA,
+	G_TK_SEMICOLON,
+	G_TK_PERIOD,
+	G_TK_PERIOD_PERIOD,
+	G_TK_COLON,
+	G_TK_DOLLAR,
+	G_TK_FORWARD_ARROW,
+	G_TK_WILDCARD, // UNDERSCORE
+	G_TK_NEWLINE, // never stored, rebuilt from the line table
+	G_TK_MAX, // INDENT, never stored
+	G_TK_MAX, // DEDENT, never stored
+	G_TK_CONST_PI,
+	G_TK_CONST_TAU,
+	G_TK_CONST_INF,
+	G_TK_CONST_NAN,
+	G_TK_ERROR, // VCS_CONFLICT_MARKER
+	G_TK_ERROR, // BACKTICK
+	G_TK_QUESTION_MARK,
+	G_TK_ERROR,
+	G_TK_EOF,
+};
+
+int GDScriptDecomp_77dcf97::get_token_count() const {
+	return sizeof(token_table) / sizeof(token_table[0]);
+}
+
+static _FORCE_INLINE_ void _append_utf8(LocalVector<char> &r_data, uint32_t p_char) {
+	if (p_char < 0x80) {
+		r_data.push_back(p_char);
+	} else if (p_char < 0x800) {
+		r_data.push_back(0xC0 | (p_char >> 6));
+		r_data.push_back(0x80 | (p_char & 0x3F));
+	} else if (p_char < 0x10000) {
+		r_data.push_back(0xE0 | (p_char >> 12));
+		r_data.push_back(0x80 | ((p_char >> 6) & 0x3F));
+		r_data.push_back(0x80 | (p_char & 0x3F));
+	} else {
+		r_data.push_back(0xF0 | (p_char >> 18));
+		r_data.push_back(0x80 | ((p_char >> 12) & 0x3F));
+		r_data.push_back(0x80 | ((p_char >> 6) & 0x3F));
+		r_data.push_back(0x80 | (p_char & 0x3F));
+	}
+}
+
+Error GDScriptDecomp_77dcf97::_load_bytecode(const uint8_t *p_buffer, size_t p_len, IdentifierTable &r_identifiers, Vector<Variant> &r_constants, TokenStream *r_tokens) {
+	uint64_t ticks = _get_ticks_nsec();
+	ERR_FAIL_COND_V(!p_buffer || p_len < HEADER_SIZE || p_len > INT_MAX, ERR_INVALID_DATA);
+	ERR_FAIL_COND_V(p_buffer[0] != 'G' || p_buffer[1] != 'D' || p_buffer[2] != 'S' || p_buffer[3] != 'C', ERR_INVALID_DATA);
+	ERR_FAIL_COND_V(decode_uint32(&p_buffer[4]) != (uint32_t)bytecode_version, ERR_INVALID_DATA);
+
+	const uint8_t *buf = p_buffer + HEADER_SIZE;
+	int total_len = p_len - HEADER_SIZE;
+	uint32_t decompressed_size = decode_uint32(&p_buffer[8]);
+	if (decompressed_size > 0) {
+		ERR_FAIL_COND_V(decompressed_size > INT_MAX, ERR_INVALID_DATA);
+		decompressed.resize(decompressed_size);
+		int result = Compression::decompress(decompressed.ptr(), decompressed_size, buf, total_len, Compression::MODE_ZSTD);
+		if (result != (int)decompressed_size) {
+			error_message = RTR("Failed to decompress the tokenizer buffer");
+			return ERR_INVALID_DATA;
+		}
+		buf = decompressed.ptr();
+		total_len = decompressed_size;
+	}
+
+	ERR_FAIL_COND_V(total_len < CONTENT_HEADER_SIZE, ERR_INVALID_DATA);
+	int identifier_count = decode_uint32(&buf[0]);
+	int constant_count = decode_uint32(&buf[4]);
+	int line_count = decode_uint32(&buf[8]);
+	int token_count = decode_uint32(&buf[16]);
+
+	const uint8_t *b = &buf[CONTENT_HEADER_SIZE];
+	total_len -= CONTENT_HEADER_SIZE;
+	ERR_FAIL_COND_V(identifier_count < 0 || constant_count < 0 || line_count < 0 || token_count < 0, ERR_INVALID_DATA);
+	ERR_FAIL_COND_V(identifier_count > total_len / 4, ERR_INVALID_DATA);
+
+	// Identifiers are UTF-32 with every byte xored, they go to the table as UTF-8 like the 3.x ones
+	r_identifiers.entries.resize(identifier_count);
+	r_identifiers.data.clear();
+	for (int i = 0; i < identifier_count; i++) {
+		ERR_FAIL_COND_V(total_len < 4, ERR_INVALID_DATA);
+		uint32_t len = decode_uint32(b);
+		b += 4;
+		total_len -= 4;
+		ERR_FAIL_COND_V(len > (uint32_t)total_len / 4, ERR_INVALID_DATA);
+
+		IdentifierTable::Entry &e = r_identifiers.entries[i];
+		e.ofs = r_identifiers.data.size();
+		for (uint32_t j = 0; j < len; j++) {
+			uint32_t c = decode_uint32(b) ^ 0xb6b6b6b6;
+			ERR_FAIL_COND_V(c > 0x10FFFF, ERR_INVALID_DATA);
+			_append_utf8(r_identifiers.data, c);
+			b += 4;
+		}
+		total_len -= len * 4;
+		e.len = r_identifiers.data.size() - e.ofs;
+	}
+	stats.identifiers += identifier_count;
+	_stats_lap(STATS_IDENTIFIERS, ticks);
+
+	r_constants.resize(constant_count);
+	for (int i = 0; i < constant_count; i++) {
+		Variant v;
+		int len;
+		Error err = decode_variant(v, b, total_len, &len, false);
+		if (err) {
+			error_message = RTR("Invalid constant");
+			return err;
+		}
+		b += len;
+		total_len -= len;
+		r_constants.write[i] = v;
+	}
+	stats.constants += constant_count;
+	_stats_lap(STATS_CONSTANTS, ticks);
+	if (!r_tokens) {
+		return OK;
+	}
+
+	// Token and line, then token and column, for the first token of every line
+	ERR_FAIL_COND_V(line_count > total_len / 16, ERR_INVALID_DATA);
+	// Every token takes at least 5 bytes after the line table, checked before anything is sized by token_count
+	ERR_FAIL_COND_V(token_count > (total_len - line_count * 16) / 5, ERR_INVALID_DATA);
+	line_columns.resize(token_count);
+	if (token_count > 0) {
+		memset(line_columns.ptr(), 0, token_count * sizeof(uint32_t));
+	}
+	const uint8_t *column_block = b + line_count * 8;
+	for (int k = 0; k < line_count; k++) {
+		uint32_t token = decode_uint32(column_block + k * 8);
+		if (token < (uint32_t)token_count) {
+			line_columns[token] = MAX(decode_uint32(column_block + k * 8 + 4), 1U);
+		}
+	}
+	b += line_count * 16;
+	total_len -= line_count * 16;
+
+	const uint32_t token_table_size = get_token_count();
+	uint8_t token_map[BINARY_TOKEN_MASK + 1];
+	for (uint32_t i = 0; i <= BINARY_TOKEN_MASK; i++) {
+		token_map[i] = i < token_table_size ? token_table[i] : G_TK_MAX;
+	}
+
+	// At most one newline is added in front of every token starting a line
+	const uint32_t max_tokens = token_count + line_count;
+	r_tokens->kinds.resize(max_tokens);
+	r_tokens->payloads.resize(max_tokens);
+	r_tokens->lines.resize(max_tokens);
+	uint8_t *kinds = r_tokens->kinds.ptr();
+	uint32_t *payloads = r_tokens->payloads.ptr();
+	uint32_t *lines = r_tokens->lines.ptr();
+
+	// Indentation is tracked the way the Godot 4 tokenizer does it, with a stack of columns.
+	// Inside brackets lines don't open blocks, except for lambdas, so the block level is restored once they close.
+	indent_stack.clear();
+	uint32_t block_indents = 0;
+	int bracket_depth = 0;
+	uint8_t last_token = G_TK_NEWLINE;
+	uint32_t out = 0;
+	for (int i = 0; i < token_count; i++) {
+		ERR_FAIL_COND_V(total_len < 1, ERR_INVALID_DATA);
+		uint32_t token;
+		if ((*b) & TOKEN_BYTE_MASK) {
+			ERR_FAIL_COND_V(total_len < 8, ERR_INVALID_DATA);
+			token = decode_uint32(b) & ~TOKEN_BYTE_MASK;
+			b += 4;
+			total_len -= 8;
+		} else {
+			ERR_FAIL_COND_V(total_len < 5, ERR_INVALID_DATA);
+			token = *b;
+			b += 1;
+			total_len -= 5;
+		}
+		uint32_t line = decode_uint32(b);
+		b += 4;
+
+		uint32_t column = line_columns[i];
+		if (column > 0 && out > 0) {
+			uint32_t indent = column - 1;
+			uint32_t min_size = bracket_depth > 0 ? block_indents : 0;
+			bool new_line = true;
+			if (indent > (indent_stack.is_empty() ? 0 : indent_stack[indent_stack.size() - 1])) {
+				if (last_token == G_TK_COLON || bracket_depth > 0) {
+					indent_stack.push_back(indent);
+				} else {
+					// Continued with a backslash, join it with the previous line
+					new_line = false;
+				}
+			} else {
+				uint32_t size = indent_stack.size();
+				while (size > min_size && indent_stack[size - 1] > indent) {
+					size--;
+				}
+				indent_stack.resize(size);
+			}
+			if (new_line) {
+				kinds[out] = G_TK_NEWLINE;
+				payloads[out] = indent_stack.size();
+				lines[out] = lines[out - 1];
+				out++;
+			}
+		}
+
+		uint8_t kind = token_map[token & BINARY_TOKEN_MASK];
+		kinds[out] = kind;
+		payloads[out] = token >> TOKEN_BITS;
+		lines[out] = line & TOKEN_LINE_MASK;
+		out++;
+
+		switch (kind) {
+			case G_TK_PARENTHESIS_OPEN:
+			case G_TK_BRACKET_OPEN:
+			case G_TK_CURLY_BRACKET_OPEN: {
+				if (bracket_depth == 0) {
+					block_indents = indent_stack.size();
+				}
+				bracket_depth++;
+			} break;
+			case G_TK_PARENTHESIS_CLOSE:
+			case G_TK_BRACKET_CLOSE:
+			case G_TK_CURLY_BRACKET_CLOSE: {
+				if (bracket_depth > 0 && --bracket_depth == 0) {
+					indent_stack.resize(block_indents);
+				}
+			} break;
+			default: {
+			} break;
+		}
+		last_token = kind;
+	}
+
+	r_tokens->kinds.resize(out);
+	r_tokens->payloads.resize(out);
+	r_tokens->lines.resize(out);
+	stats.tokens += out;
+	_stats_lap(STATS_TOKENS, ticks);
+
+	return OK;
+}
@@ -0,0 +1,46 @@
+/*************************************************************************/
+/*  bytecode_77dcf97.h                                                   */
+/*************************************************************************/
+
+#ifndef GDSCRIPT_DECOMP_77dcf97_H
+#define GDSCRIPT_DECOMP_77dcf97_H
+
+#include "bytecode_base.h"
+
+// Godot 4 binary tokenizer buffer. Unlike the 3.x bytecode there are no newline or
+// indentation tokens, those are rebuilt from the line and column tables while loading.
+class GDScriptDecomp_77dcf97 : public GDScriptDecomp {
+	GDCLASS(GDScriptDecomp_77dcf97, GDScriptDecomp);
+
+	enum {
+		HEADER_SIZE = 12, // magic, version, decompressed size
+		CONTENT_HEADER_SIZE = 20, // identifiers, constants, token lines, unused, tokens
+		BINARY_TOKEN_MASK = (1 << (TOKEN_BITS - 1)) - 1,
+	};
+
+	// Scratch buffers, reused across calls
+	LocalVector<uint8_t> decompressed;
+	LocalVector<uint32_t> line_columns; // column of the tokens starting a line, 0 for the others
+	LocalVector<uint32_t> indent_stack;
+
+protected:
+	static void _bind_methods(){};
+
+	static const int bytecode_version = 100;
+	static const int variant_ver_major = 4;
+	static const GlobalToken token_table[];
+
+	virtual Error _load_bytecode(const uint8_t *p_buffer, size_t p_len, IdentifierTable &r_identifiers, Vector<Variant> &r_constants, TokenStream *r_tokens) override;
+
+public:
+	virtual uint64_t get_commit() const override { return 0x77dcf97; }
+	virtual int get_bytecode_version() const override { return bytecode_version; }
+	virtual int get_variant_ver_major() const override { return variant_ver_major; }
+	virtual const GlobalToken *get_token_table() const override { return token_table; }
+	virtual int get_token_count() const override;
+	// Utility functions and built-in types are plain identifiers in Godot 4
+	virtual const char *get_function_name(int p_func) const override { return ""; }
+	virtual int get_function_count() const override { return 0; }
+};
+
+#endif
@@ -1,31 +0,0 @@
-
-/*************************************************************************/
-/*  bytecode_a56d6ff.h                                                   */
-/*************************************************************************/
-
-#ifndef GDSCRIPT_DECOMP_a56d6ff_H
-#define GDSCRIPT_DECOMP_a56d6ff_H
-
-#include "bytecode_base.h"
-
-class GDScriptDecomp_a56d6ff : public GDScriptDecomp {
-	GDCLASS(GDScriptDecomp_a56d6ff, GDScriptDecomp);
-
-protected:
-	static void _bind_methods(){};
-
-	static const int bytecode_version = 12;
-
-	enum {
-		TOKEN_BYTE_MASK = 0x80,
-		TOKEN_BITS = 8,
-		TOKEN_MASK = (1 << TOKEN_BITS) - 1,
-		TOKEN_LINE_BITS = 24,
-		TOKEN_LINE_MASK = (1 << TOKEN_LINE_BITS) - 1,
-	};
-
-public:
-	virtual Error decompile_buffer(Vector<uint8_t> p_buffer) override;
-};
-
-#endif
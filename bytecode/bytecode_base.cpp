@@ -3,23 +3,27 @@
 /*************************************************************************/
 
 #include "bytecode_base.h"
+#include "bytecode_versions.h"
 
 #include "core/config/engine.h"
+#include "core/error/error_list.h"
+#include "core/io/dir_access.h"
 #include "core/io/file_access.h"
-#include "core/io/file_access_encrypted.h"
 #include "core/io/image.h"
 #include "core/io/marshalls.h"
+#include "core/object/worker_thread_pool.h"
+#include "core/os/os.h"
+#include "core/templates/rb_set.h"
+#include "utility/gdre_packed_data.h"
+#include "utility/gdre_settings.h"
 
+#include <chrono>
 #include <limits.h>
 
 #define _S(a) ((int32_t)a)
 #define ERR_FAIL_ADD_OF(a, b, err) ERR_FAIL_COND_V(_S(b) < 0 || _S(a) < 0 || _S(a) > INT_MAX - _S(b), err)
 #define ERR_FAIL_MUL_OF(a, b, err) ERR_FAIL_COND_V(_S(a) < 0 || _S(b) <= 0 || _S(a) > INT_MAX / _S(b), err)
 
-#define ENCODE_MASK 0xFF
-#define ENCODE_FLAG_64 1 << 16
-#define ENCODE_FLAG_OBJECT_AS_ID 1 << 16
-
 static Error _decode_string(const uint8_t *&buf, int &len, int *r_len, String &r_string) {
 	ERR_FAIL_COND_V(len < 4, ERR_INVALID_DATA);
 
@@ -58,59 +62,1521 @@ static Error _decode_string(const uint8_t *&buf, int &len, int *r_len, String &r
 void GDScriptDecomp::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("decompile_byte_code", "path"), &GDScriptDecomp::decompile_byte_code);
 	ClassDB::bind_method(D_METHOD("decompile_byte_code_encrypted", "path", "key"), &GDScriptDecomp::decompile_byte_code_encrypted);
+	ClassDB::bind_method(D_METHOD("decompile_byte_code_to_file", "path", "target_path", "key"), &GDScriptDecomp::decompile_byte_code_to_file, DEFVAL(Vector<uint8_t>()));
+
+	ClassDB::bind_method(D_METHOD("decompile_files", "paths", "output_dir", "threads", "key"), &GDScriptDecomp::decompile_files, DEFVAL(-1), DEFVAL(Vector<uint8_t>()));
+	ClassDB::bind_method(D_METHOD("decompile_pack_files", "output_dir", "threads"), &GDScriptDecomp::decompile_pack_files, DEFVAL(-1));
+	ClassDB::bind_method(D_METHOD("get_batch_errors"), &GDScriptDecomp::get_batch_errors);
+	ClassDB::bind_method(D_METHOD("decompile_pack_files_incremental", "output_dir", "manifest_path", "threads"), &GDScriptDecomp::decompile_pack_files_incremental, DEFVAL(String()), DEFVAL(-1));
+	ClassDB::bind_method(D_METHOD("get_change_report"), &GDScriptDecomp::get_change_report);
+
+	ClassDB::bind_method(D_METHOD("set_preserve_line_numbers", "enable"), &GDScriptDecomp::set_preserve_line_numbers);
+	ClassDB::bind_method(D_METHOD("is_preserving_line_numbers"), &GDScriptDecomp::is_preserving_line_numbers);
+
+	ClassDB::bind_method(D_METHOD("set_cache", "cache"), &GDScriptDecomp::set_cache);
+	ClassDB::bind_method(D_METHOD("get_cache"), &GDScriptDecomp::get_cache);
+	ClassDB::bind_method(D_METHOD("get_decompiler_id"), &GDScriptDecomp::get_decompiler_id);
+
+	ClassDB::bind_method(D_METHOD("get_stats"), &GDScriptDecomp::get_stats);
+	ClassDB::bind_method(D_METHOD("reset_stats"), &GDScriptDecomp::reset_stats);
 
 	ClassDB::bind_method(D_METHOD("get_script_text"), &GDScriptDecomp::get_script_text);
 	ClassDB::bind_method(D_METHOD("get_error_message"), &GDScriptDecomp::get_error_message);
+
+	ClassDB::bind_static_method("GDScriptDecomp", D_METHOD("create", "commit_or_version"), &GDScriptDecomp::create);
+	ClassDB::bind_static_method("GDScriptDecomp", D_METHOD("detect_version", "buffer"), &GDScriptDecomp::_detect_version);
+	ClassDB::bind_static_method("GDScriptDecomp", D_METHOD("detect_version_from_files", "paths", "max_samples"), &GDScriptDecomp::_detect_version_from_files, DEFVAL(8));
+}
+
+Error GDScriptDecryptContext::set_key(const Vector<uint8_t> &p_key) {
+	key_set = false;
+	ERR_FAIL_COND_V(p_key.size() != 32, ERR_INVALID_PARAMETER);
+	// CFB uses the encryption key schedule in both directions
+	Error err = aes.set_encode_key(p_key.ptr(), 256);
+	ERR_FAIL_COND_V(err != OK, err);
+	key_set = true;
+	return OK;
+}
+
+Error GDScriptDecryptContext::decrypt_file(const String &p_path, LocalVector<uint8_t> &r_buffer, uint64_t &r_len) const {
+	ERR_FAIL_COND_V(!key_set, ERR_UNCONFIGURED);
+	Ref<FileAccess> fa = FileAccess::open(p_path, FileAccess::READ);
+	ERR_FAIL_COND_V_MSG(fa.is_null(), ERR_FILE_CANT_OPEN, "Can't open file '" + p_path + "'.");
+
+	// Same layout FileAccessEncrypted reads, but without its intermediate buffer
+	uint8_t header[HEADER_SIZE];
+	ERR_FAIL_COND_V(fa->get_buffer(header, HEADER_SIZE) != HEADER_SIZE, ERR_FILE_CORRUPT);
+	ERR_FAIL_COND_V(decode_uint32(header) != HEADER_MAGIC, ERR_FILE_UNRECOGNIZED);
+	uint64_t length = decode_uint64(&header[20]);
+	uint64_t padded_length = length % 16 ? length + 16 - (length % 16) : length;
+	ERR_FAIL_COND_V(padded_length > UINT32_MAX || fa->get_length() < HEADER_SIZE + padded_length, ERR_FILE_CORRUPT);
+
+	r_buffer.resize(padded_length);
+	ERR_FAIL_COND_V(fa->get_buffer(r_buffer.ptr(), padded_length) != padded_length, ERR_FILE_CORRUPT);
+	uint8_t iv[16];
+	memcpy(iv, &header[28], 16);
+	ERR_FAIL_COND_V(aes.decrypt_cfb(padded_length, iv, r_buffer.ptr(), r_buffer.ptr()) != OK, ERR_FILE_CORRUPT);
+
+	uint8_t md5[16];
+	ERR_FAIL_COND_V(CryptoCore::md5(r_buffer.ptr(), length, md5) != OK, ERR_BUG);
+	ERR_FAIL_COND_V_MSG(memcmp(md5, &header[4], 16) != 0, ERR_FILE_CORRUPT, "The MD5 sum of the decrypted file '" + p_path + "' does not match, the file is corrupt or the key is invalid.");
+	r_len = length;
+	return OK;
+}
+
+Error GDScriptDecomp::_read_byte_code(const String &p_path, const GDScriptDecryptContext *p_decrypt, uint64_t &r_len) {
+	uint64_t ticks = _get_ticks_nsec();
+	// Reset first, so a failure doesn't report the message of the previous script
+	error_message = RTR("No error");
+	const uint8_t *old_buffer = file_buffer.ptr();
+	mapped_file = Ref<FileAccess>();
+	file_data = nullptr;
+	if (p_decrypt) {
+		Error err = p_decrypt->decrypt_file(p_path, file_buffer, r_len);
+		ERR_FAIL_COND_V(err == ERR_FILE_CANT_OPEN, err);
+		ERR_FAIL_COND_V(err, ERR_FILE_CORRUPT);
+		file_data = file_buffer.ptr();
+	} else {
+		Ref<FileAccess> fa = FileAccess::open(p_path, FileAccess::READ);
+		ERR_FAIL_COND_V_MSG(fa.is_null(), ERR_FILE_CANT_OPEN, "Can't open file '" + p_path + "'.");
+		file_data = FileAccessPackMapped::get_view(fa, r_len);
+		if (file_data) {
+			// Unencrypted pack entries are decompiled straight out of the mapped pack
+			mapped_file = fa;
+		} else {
+			file_buffer.resize(fa->get_length());
+			r_len = fa->get_buffer(file_buffer.ptr(), file_buffer.size());
+			file_data = file_buffer.ptr();
+		}
+	}
+	if (file_buffer.ptr() != old_buffer) {
+		stats.allocations++;
+	}
+	_stats_lap(STATS_READ, ticks);
+	return OK;
 }
 
-void GDScriptDecomp::_ensure_space(String &p_code) {
-	if (!p_code.ends_with(" ")) {
-		p_code += String(" ");
+Error GDScriptDecomp::load_script_symbols(const String &p_path, const GDScriptDecryptContext *p_decrypt, Vector<String> &r_symbols) {
+	r_symbols.clear();
+	uint64_t len;
+	Error err = _read_byte_code(p_path, p_decrypt, len);
+	if (err) {
+		return err;
+	}
+	err = _load_bytecode(file_data, len, identifiers, constants.values, nullptr);
+	if (err) {
+		return err;
+	}
+
+	for (uint32_t i = 0; i < identifiers.size(); i++) {
+		r_symbols.push_back(identifiers.get_string(i));
 	}
+	for (int i = 0; i < constants.values.size(); i++) {
+		// Resource paths, signal and method names are passed as strings
+		const Variant &v = constants.values[i];
+		if (v.get_type() == Variant::STRING || v.get_type() == Variant::STRING_NAME || v.get_type() == Variant::NODE_PATH) {
+			r_symbols.push_back(String(v));
+		}
+	}
+	return OK;
 }
 
 Error GDScriptDecomp::decompile_byte_code_encrypted(const String &p_path, Vector<uint8_t> p_key) {
-	Vector<uint8_t> bytecode;
+	GDScriptDecryptContext decrypt;
+	Error err = decrypt.set_key(p_key);
+	ERR_FAIL_COND_V(err, err);
+	uint64_t len;
+	err = _read_byte_code(p_path, &decrypt, len);
+	if (err) {
+		return err;
+	}
+	return decompile_span(file_data, len);
+}
 
-	Ref<FileAccess> fa = FileAccess::open(p_path, FileAccess::READ);
-	ERR_FAIL_COND_V(fa.is_null(), ERR_FILE_CANT_OPEN);
+Error GDScriptDecomp::decompile_byte_code(const String &p_path) {
+	uint64_t len;
+	Error err = _read_byte_code(p_path, nullptr, len);
+	if (err) {
+		return err;
+	}
+	return decompile_span(file_data, len);
+}
 
-	Ref<FileAccessEncrypted> fae;
-	fae.instantiate();
-	ERR_FAIL_COND_V(fae.is_null(), ERR_FILE_CORRUPT);
+void GDScriptDecomp::_file_sink(void *p_userdata, const char *p_data, uint32_t p_len) {
+	FileSink *sink = (FileSink *)p_userdata;
+	uint64_t begin = _get_ticks_nsec();
+	sink->file->store_buffer((const uint8_t *)p_data, p_len);
+	sink->stats->phase_nsec[STATS_WRITE] += _get_ticks_nsec() - begin;
+}
 
-	Error err = fae->open_and_parse(fa, p_key, FileAccessEncrypted::MODE_READ);
+Error GDScriptDecomp::decompile_span_to_sink(const uint8_t *p_data, size_t p_len, GDScriptTextBuffer::SinkFunc p_func, void *p_userdata) {
+	script_buffer.set_sink(p_func, p_userdata);
+	Error err = decompile_span(p_data, p_len);
+	script_buffer.set_sink(nullptr, nullptr);
+	script_buffer.clear();
+	return err;
+}
 
+Error GDScriptDecomp::decompile_byte_code_to_file(const String &p_path, const String &p_target_path, const Vector<uint8_t> &p_key) {
+	if (p_key.is_empty()) {
+		return _decompile_byte_code_to_file(p_path, p_target_path, nullptr);
+	}
+	GDScriptDecryptContext decrypt;
+	Error err = decrypt.set_key(p_key);
+	ERR_FAIL_COND_V(err, err);
+	return _decompile_byte_code_to_file(p_path, p_target_path, &decrypt);
+}
+
+Error GDScriptDecomp::_decompile_byte_code_to_file(const String &p_path, const String &p_target_path, const GDScriptDecryptContext *p_decrypt) {
+	uint64_t len;
+	Error err = _read_byte_code(p_path, p_decrypt, len);
 	if (err) {
-		ERR_FAIL_COND_V(err, ERR_FILE_CORRUPT);
+		return err;
 	}
+	Ref<FileAccess> fa = FileAccess::open(p_target_path, FileAccess::WRITE, &err);
+	ERR_FAIL_COND_V_MSG(fa.is_null(), err, "Can't open file '" + p_target_path + "' for writing.");
+	FileSink sink;
+	sink.file = fa.ptr();
+	sink.stats = &stats;
+	err = decompile_span_to_sink(file_data, len, &GDScriptDecomp::_file_sink, &sink);
+	if (err) {
+		// Don't leave half a script behind
+		fa = Ref<FileAccess>();
+		DirAccess::create(DirAccess::ACCESS_FILESYSTEM)->remove(p_target_path);
+	}
+	return err;
+}
 
-	bytecode.resize(fae->get_length());
-	fae->get_buffer(bytecode.ptrw(), bytecode.size());
+void GDScriptBatchProgress::wait(WorkerThreadPool::GroupID p_group, int p_total) {
+	if (func) {
+		while (!WorkerThreadPool::get_singleton()->is_group_task_completed(p_group)) {
+			if (func(userdata, done.get(), p_total)) {
+				cancelled.set();
+			}
+			OS::get_singleton()->delay_usec(POLL_INTERVAL_USEC);
+		}
+		func(userdata, done.get(), p_total);
+	}
+	WorkerThreadPool::get_singleton()->wait_for_group_task_completion(p_group);
+}
 
-	error_message = RTR("No error");
+String GDScriptDecomp::_decompile_batch_file(uint32_t p_index, BatchDecompileData *p_data) {
+	const String &path = p_data->paths[p_index];
+	String cache_key;
+	if (p_data->cache.is_valid()) {
+		String md5 = p_data->hashes.is_empty() ? String() : p_data->hashes[p_index];
+		if (md5.is_empty()) {
+			md5 = FileAccess::get_md5(path);
+		}
+		if (!md5.is_empty()) {
+			cache_key = GDScriptDecompCache::make_key(md5, p_data->decompiler_id);
+			if (p_data->cache->fetch(cache_key, p_data->targets[p_index]) == OK) {
+				return String();
+			}
+		}
+	}
 
-	return decompile_buffer(bytecode);
+	bool encrypted = path.get_extension().to_lower() == "gde" && p_data->decrypt.is_key_set();
+	Error err = _decompile_byte_code_to_file(path, p_data->targets[p_index], encrypted ? &p_data->decrypt : nullptr);
+	if (err) {
+		return get_failure_message(err);
+	}
+	if (!cache_key.is_empty()) {
+		p_data->cache->store_file(cache_key, p_data->targets[p_index]);
+	}
+	return String();
 }
 
-Error GDScriptDecomp::decompile_byte_code(const String &p_path) {
-	Vector<uint8_t> bytecode;
+void GDScriptDecomp::_decompile_files_worker(uint32_t p_worker, BatchDecompileData *p_data) {
+	// Every worker gets its own decompiler, so the output buffer and error_message aren't shared
+	GDScriptDecomp *decomp = create_decomp_for_commit(p_data->commit);
+	ERR_FAIL_COND_MSG(!decomp, "Failed to create the decompiler for commit " + String::num_uint64(p_data->commit, 16) + ".");
+	decomp->set_preserve_line_numbers(p_data->preserve_line_numbers);
+
+	while (!p_data->progress.cancelled.is_set()) {
+		uint32_t i = p_data->next_file.postincrement();
+		if (i >= (uint32_t)p_data->paths.size()) {
+			break;
+		}
+		p_data->errors[i] = decomp->_decompile_batch_file(i, p_data);
+		p_data->progress.done.increment();
+	}
+	p_data->worker_stats[p_worker] = decomp->stats;
+	memdelete(decomp);
+}
+
+Error GDScriptDecomp::decompile_files(const Vector<String> &p_paths, const String &p_output_dir, int p_threads, const Vector<uint8_t> &p_key) {
+	return _decompile_files(p_paths, Vector<String>(), p_output_dir, p_threads, p_key);
+}
+
+Error GDScriptDecomp::_decompile_files(const Vector<String> &p_paths, const Vector<String> &p_hashes, const String &p_output_dir, int p_threads, const Vector<uint8_t> &p_key) {
+	batch_errors.clear();
+	if (p_paths.is_empty()) {
+		return OK;
+	}
 
-	bytecode = FileAccess::get_file_as_array(p_path);
+	BatchDecompileData data;
+	data.commit = get_commit();
+	data.decompiler_id = get_decompiler_id();
+	data.cache = cache.is_valid() && cache->is_open() ? cache : Ref<GDScriptDecompCache>();
+	data.paths = p_paths;
+	data.hashes = p_hashes;
+	data.preserve_line_numbers = preserve_line_numbers;
+
+	// The key schedule is set up once for the whole batch
+	Vector<uint8_t> key = p_key.size() == 32 ? p_key : GDRESettings::get_singleton()->get_encryption_key();
+	if (key.size() == 32) {
+		data.decrypt.set_key(key);
+	}
+
+	Ref<DirAccess> da = DirAccess::create(DirAccess::ACCESS_FILESYSTEM);
+	RBSet<String> dirs;
+	data.targets.resize(p_paths.size());
+	for (int i = 0; i < p_paths.size(); i++) {
+		data.targets.write[i] = _get_target_path(p_output_dir, p_paths[i]);
+		String dir = data.targets[i].get_base_dir();
+		if (!dirs.has(dir)) {
+			dirs.insert(dir);
+			da->make_dir_recursive(dir);
+		}
+	}
+
+	Vector<String> errors;
+	errors.resize(p_paths.size());
+	errors.fill(RTR("Not decompiled"));
+	data.errors = errors.ptrw();
+
+	int threads = p_threads > 0 ? p_threads : WorkerThreadPool::get_singleton()->get_thread_count();
+	threads = CLAMP(threads, 1, p_paths.size());
+	LocalVector<DecompStats> worker_stats;
+	worker_stats.resize(threads);
+	data.worker_stats = worker_stats.ptr();
+	data.progress.func = batch_progress_func;
+	data.progress.userdata = batch_progress_userdata;
+	WorkerThreadPool::GroupID group_id = WorkerThreadPool::get_singleton()->add_template_group_task(this, &GDScriptDecomp::_decompile_files_worker, &data, threads, threads, true, "GDScriptDecomp::decompile_files");
+	data.progress.wait(group_id, p_paths.size());
+	for (int i = 0; i < threads; i++) {
+		stats.add(worker_stats[i]);
+	}
+
+	for (int i = 0; i < errors.size(); i++) {
+		if (!errors[i].is_empty()) {
+			batch_errors[p_paths[i]] = errors[i];
+		}
+	}
+	return batch_errors.is_empty() ? OK : ERR_INVALID_DATA;
+}
+
+String GDScriptDecomp::_get_target_path(const String &p_output_dir, const String &p_path) {
+	// Files from a pack keep their directory structure, loose files are written flat
+	String rel_path = p_path.begins_with("res://") ? p_path.replace_first("res://", "") : p_path.get_file();
+	return p_output_dir.plus_file(rel_path.get_basename() + ".gd");
+}
+
+void GDScriptDecomp::_get_pack_scripts(Vector<String> &r_paths, Vector<String> &r_hashes) {
+	Vector<String> filters;
+	filters.push_back("*.gdc");
+	filters.push_back("*.gde");
+	Vector<Ref<PackedFileInfo>> files = GDRESettings::get_singleton()->get_file_info_list(filters);
+	for (int i = 0; i < files.size(); i++) {
+		r_paths.push_back(files[i]->get_path());
+		// Some packs are written without checksums
+		Vector<uint8_t> md5 = files[i]->get_md5();
+		bool has_md5 = false;
+		for (int j = 0; j < md5.size(); j++) {
+			has_md5 = has_md5 || md5[j] != 0;
+		}
+		r_hashes.push_back(has_md5 ? String::hex_encode_buffer(md5.ptr(), md5.size()) : String());
+	}
+}
+
+Error GDScriptDecomp::decompile_pack_files(const String &p_output_dir, int p_threads) {
+	ERR_FAIL_COND_V_MSG(!GDRESettings::get_singleton()->is_pack_loaded(), ERR_DOES_NOT_EXIST, "No pack loaded");
+	Vector<String> paths;
+	Vector<String> hashes;
+	_get_pack_scripts(paths, hashes);
+	return _decompile_files(paths, hashes, p_output_dir, p_threads, Vector<uint8_t>());
+}
+
+Dictionary GDScriptDecomp::get_batch_errors() const {
+	return batch_errors;
+}
+
+uint64_t GDScriptDecomp::_hash_token_stream() const {
+	// Identifiers and constants are hashed by value, their indices change whenever the tables are reordered.
+	// The stream is hashed with MD5, a 32-bit hash of each value would let two scripts collide far too easily.
+	LocalVector<uint32_t> constant_ofs;
+	LocalVector<uint8_t> constant_data;
+	constant_ofs.resize(constants.size() + 1);
+	for (uint32_t i = 0; i < constants.size(); i++) {
+		constant_ofs[i] = constant_data.size();
+		int len;
+		if (encode_variant(constants.values[i], nullptr, len) == OK) {
+			constant_data.resize(constant_ofs[i] + len);
+			encode_variant(constants.values[i], &constant_data[constant_ofs[i]], len);
+		}
+	}
+	constant_ofs[constants.size()] = constant_data.size();
+
+	LocalVector<uint8_t> stream;
+	uint32_t pos = 0;
+	// Kind, payload or value length, line
+	stream.resize(4 + tokens.size() * 9);
+	encode_uint32(tokens.size(), &stream[pos]);
+	pos += 4;
+	for (uint32_t i = 0; i < tokens.size(); i++) {
+		uint32_t payload = tokens.payloads[i];
+		const uint8_t *value = nullptr;
+		uint32_t value_len = 0;
+		switch (tokens.kinds[i]) {
+			case G_TK_IDENTIFIER:
+			case G_TK_ANNOTATION: {
+				if (payload < identifiers.size()) {
+					value = (const uint8_t *)identifiers.get_data(payload);
+					value_len = identifiers.get_length(payload);
+				}
+			} break;
+			case G_TK_CONSTANT: {
+				if (payload < constants.size()) {
+					value = constant_data.ptr() + constant_ofs[payload];
+					value_len = constant_ofs[payload + 1] - constant_ofs[payload];
+				}
+			} break;
+			default:
+				break;
+		}
+		if (value) {
+			// Length prefixed, so the bytes of consecutive values can't be split differently
+			stream.resize(stream.size() + value_len);
+			stream[pos++] = tokens.kinds[i];
+			encode_uint32(value_len, &stream[pos]);
+			memcpy(&stream[pos + 4], value, value_len);
+			pos += 4 + value_len;
+		} else {
+			stream[pos++] = tokens.kinds[i];
+			encode_uint32(payload, &stream[pos]);
+			pos += 4;
+		}
+		if (preserve_line_numbers) {
+			encode_uint32(tokens.get_line(i), &stream[pos]);
+			pos += 4;
+		}
+	}
+
+	uint8_t md5[16];
+	ERR_FAIL_COND_V(CryptoCore::md5(stream.ptr(), pos, md5) != OK, 0);
+	return decode_uint64(md5);
+}
+
+Error GDScriptDecomp::_hash_byte_code(const String &p_path, const GDScriptDecryptContext *p_decrypt, uint64_t &r_hash) {
+	uint64_t len;
+	Error err = _read_byte_code(p_path, p_decrypt, len);
+	if (err) {
+		return err;
+	}
+	err = _load_bytecode(file_data, len, identifiers, constants.values, &tokens);
+	if (err) {
+		return err;
+	}
+	r_hash = _hash_token_stream();
+	return OK;
+}
+
+void GDScriptDecomp::_hash_files_worker(uint32_t p_worker, BatchDecompileData *p_data) {
+	GDScriptDecomp *decomp = create_decomp_for_commit(p_data->commit);
+	ERR_FAIL_COND_MSG(!decomp, "Failed to create the decompiler for commit " + String::num_uint64(p_data->commit, 16) + ".");
+	decomp->set_preserve_line_numbers(p_data->preserve_line_numbers);
+
+	while (true) {
+		uint32_t i = p_data->next_file.postincrement();
+		if (i >= (uint32_t)p_data->paths.size()) {
+			break;
+		}
+		const String &path = p_data->paths[i];
+		bool encrypted = path.get_extension().to_lower() == "gde" && p_data->decrypt.is_key_set();
+		Error err = decomp->_hash_byte_code(path, encrypted ? &p_data->decrypt : nullptr, p_data->token_hashes[i]);
+		p_data->errors[i] = err ? decomp->get_failure_message(err) : String();
+	}
+	p_data->worker_stats[p_worker] = decomp->stats;
+	memdelete(decomp);
+}
+
+Error GDScriptDecomp::_load_manifest(const String &p_path, const String &p_decompiler_id, HashMap<String, ManifestEntry> &r_entries) {
+	Ref<FileAccess> f = FileAccess::open(p_path, FileAccess::READ);
+	if (f.is_null()) {
+		return ERR_FILE_NOT_FOUND;
+	}
+	uint8_t magic[4];
+	f->get_buffer(magic, 4);
+	uint32_t version = f->get_32();
+	ERR_FAIL_COND_V(magic[0] != 'G' || magic[1] != 'D' || magic[2] != 'D' || magic[3] != 'M' || version != MANIFEST_FORMAT_VERSION, ERR_FILE_UNRECOGNIZED);
+
+	// Output of another decompiler revision or line mode can't be kept
+	if (f->get_pascal_string() != p_decompiler_id) {
+		return ERR_INVALID_DATA;
+	}
+	uint32_t count = f->get_32();
+	for (uint32_t i = 0; i < count; i++) {
+		String path = f->get_pascal_string();
+		ManifestEntry e;
+		e.md5 = f->get_pascal_string();
+		e.token_hash = f->get_64();
+		ERR_FAIL_COND_V(f->eof_reached(), ERR_FILE_CORRUPT);
+		r_entries[path] = e;
+	}
+	return OK;
+}
+
+Error GDScriptDecomp::_save_manifest(const String &p_path, const String &p_decompiler_id, const HashMap<String, ManifestEntry> &p_entries) {
+	Ref<FileAccess> f = FileAccess::open(p_path, FileAccess::WRITE);
+	ERR_FAIL_COND_V_MSG(f.is_null(), ERR_FILE_CANT_WRITE, "Can't write script manifest '" + p_path + "'.");
+	f->store_buffer((const uint8_t *)"GDDM", 4);
+	f->store_32(MANIFEST_FORMAT_VERSION);
+	f->store_pascal_string(p_decompiler_id);
+	f->store_32(p_entries.size());
+	for (const KeyValue<String, ManifestEntry> &E : p_entries) {
+		f->store_pascal_string(E.key);
+		f->store_pascal_string(E.value.md5);
+		f->store_64(E.value.token_hash);
+	}
+	return OK;
+}
+
+Error GDScriptDecomp::decompile_pack_files_incremental(const String &p_output_dir, const String &p_manifest_path, int p_threads) {
+	ERR_FAIL_COND_V_MSG(!GDRESettings::get_singleton()->is_pack_loaded(), ERR_DOES_NOT_EXIST, "No pack loaded");
+	String manifest_path = p_manifest_path.is_empty() ? p_output_dir.plus_file(".gdre_scripts.manifest") : p_manifest_path;
+	String decompiler_id = get_decompiler_id();
+	change_report.clear();
+
+	HashMap<String, ManifestEntry> old_entries;
+	if (_load_manifest(manifest_path, decompiler_id, old_entries) != OK) {
+		old_entries.clear();
+	}
+
+	Vector<String> paths;
+	Vector<String> hashes;
+	_get_pack_scripts(paths, hashes);
+
+	// Scripts with the MD5 of the last run are kept without reading them
+	HashMap<String, ManifestEntry> new_entries;
+	Vector<String> unchanged;
+	Vector<String> to_hash;
+	Vector<String> to_hash_md5;
+	for (int i = 0; i < paths.size(); i++) {
+		HashMap<String, ManifestEntry>::Iterator E = old_entries.find(paths[i]);
+		if (E && !hashes[i].is_empty() && E->value.md5 == hashes[i] && FileAccess::exists(_get_target_path(p_output_dir, paths[i]))) {
+			new_entries[paths[i]] = E->value;
+			unchanged.push_back(paths[i]);
+		} else {
+			to_hash.push_back(paths[i]);
+			to_hash_md5.push_back(hashes[i]);
+		}
+	}
+
+	// The others are compared by their token streams
+	Vector<uint8_t> key = GDRESettings::get_singleton()->get_encryption_key();
+	Vector<uint64_t> token_hashes;
+	token_hashes.resize(to_hash.size());
+	Vector<String> hash_errors;
+	hash_errors.resize(to_hash.size());
+	if (!to_hash.is_empty()) {
+		BatchDecompileData data;
+		data.commit = get_commit();
+		data.paths = to_hash;
+		data.preserve_line_numbers = preserve_line_numbers;
+		if (key.size() == 32) {
+			data.decrypt.set_key(key);
+		}
+		data.token_hashes = token_hashes.ptrw();
+		data.errors = hash_errors.ptrw();
+
+		int threads = p_threads > 0 ? p_threads : WorkerThreadPool::get_singleton()->get_thread_count();
+		threads = CLAMP(threads, 1, to_hash.size());
+		LocalVector<DecompStats> worker_stats;
+		worker_stats.resize(threads);
+		data.worker_stats = worker_stats.ptr();
+		WorkerThreadPool::GroupID group_id = WorkerThreadPool::get_singleton()->add_template_group_task(this, &GDScriptDecomp::_hash_files_worker, &data, threads, threads, true, "GDScriptDecomp::decompile_pack_files_incremental");
+		WorkerThreadPool::get_singleton()->wait_for_group_task_completion(group_id);
+		for (int i = 0; i < threads; i++) {
+			stats.add(worker_stats[i]);
+		}
+	}
+
+	Vector<String> added;
+	Vector<String> changed;
+	Vector<String> token_identical;
+	Vector<String> to_decompile;
+	Vector<String> to_decompile_md5;
+	for (int i = 0; i < to_hash.size(); i++) {
+		if (!hash_errors[i].is_empty()) {
+			continue;
+		}
+		ManifestEntry entry;
+		entry.md5 = to_hash_md5[i];
+		entry.token_hash = token_hashes[i];
+		HashMap<String, ManifestEntry>::Iterator E = old_entries.find(to_hash[i]);
+		if (E && E->value.token_hash == token_hashes[i] && FileAccess::exists(_get_target_path(p_output_dir, to_hash[i]))) {
+			new_entries[to_hash[i]] = entry;
+			token_identical.push_back(to_hash[i]);
+			continue;
+		}
+		(E ? changed : added).push_back(to_hash[i]);
+		to_decompile.push_back(to_hash[i]);
+		to_decompile_md5.push_back(to_hash_md5[i]);
+		new_entries[to_hash[i]] = entry;
+	}
 
+	Error err = _decompile_files(to_decompile, to_decompile_md5, p_output_dir, p_threads, key);
+	for (int i = 0; i < to_decompile.size(); i++) {
+		// Failed scripts are left out of the manifest, so the next run tries again
+		if (batch_errors.has(to_decompile[i])) {
+			new_entries.erase(to_decompile[i]);
+		}
+	}
+	for (int i = 0; i < to_hash.size(); i++) {
+		if (!hash_errors[i].is_empty()) {
+			batch_errors[to_hash[i]] = hash_errors[i];
+		}
+	}
+
+	Vector<String> removed;
+	Ref<DirAccess> da = DirAccess::create(DirAccess::ACCESS_FILESYSTEM);
+	for (const KeyValue<String, ManifestEntry> &E : old_entries) {
+		if (!new_entries.has(E.key) && !batch_errors.has(E.key)) {
+			da->remove(_get_target_path(p_output_dir, E.key));
+			removed.push_back(E.key);
+		}
+	}
+
+	change_report["added"] = added;
+	change_report["changed"] = changed;
+	change_report["unchanged"] = unchanged;
+	change_report["token_identical"] = token_identical;
+	change_report["removed"] = removed;
+	change_report["failed"] = batch_errors.keys();
+
+	Error save_err = _save_manifest(manifest_path, decompiler_id, new_entries);
+	if (!batch_errors.is_empty()) {
+		return ERR_INVALID_DATA;
+	}
+	return err != OK ? err : save_err;
+}
+
+Dictionary GDScriptDecomp::get_change_report() const {
+	return change_report;
+}
+
+void GDScriptDecomp::set_preserve_line_numbers(bool p_enable) {
+	preserve_line_numbers = p_enable;
+}
+
+bool GDScriptDecomp::is_preserving_line_numbers() const {
+	return preserve_line_numbers;
+}
+
+void GDScriptDecomp::set_cache(const Ref<GDScriptDecompCache> &p_cache) {
+	cache = p_cache;
+}
+
+Ref<GDScriptDecompCache> GDScriptDecomp::get_cache() const {
+	return cache;
+}
+
+void GDScriptDecomp::set_batch_progress_func(GDScriptBatchProgress::Func p_func, void *p_userdata) {
+	batch_progress_func = p_func;
+	batch_progress_userdata = p_userdata;
+}
+
+void GDScriptDecomp::DecompStats::add(const DecompStats &p_other) {
+	for (int i = 0; i < STATS_PHASE_MAX; i++) {
+		phase_nsec[i] += p_other.phase_nsec[i];
+	}
+	scripts += p_other.scripts;
+	identifiers += p_other.identifiers;
+	constants += p_other.constants;
+	tokens += p_other.tokens;
+	input_bytes += p_other.input_bytes;
+	output_bytes += p_other.output_bytes;
+	allocations += p_other.allocations;
+}
+
+// OS::get_ticks_usec() is too coarse for the phases of small scripts
+uint64_t GDScriptDecomp::_get_ticks_nsec() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void GDScriptDecomp::_get_scratch_buffers(const void **r_ptrs) const {
+	r_ptrs[0] = identifiers.data.ptr();
+	r_ptrs[1] = identifiers.entries.ptr();
+	r_ptrs[2] = constants.values.ptr();
+	r_ptrs[3] = constants.text.ptr();
+	r_ptrs[4] = tokens.kinds.ptr();
+	r_ptrs[5] = tokens.payloads.ptr();
+	r_ptrs[6] = tokens.lines.ptr();
+	r_ptrs[7] = script_buffer.ptr();
+}
+
+void GDScriptDecomp::_count_reallocations(const void *const *p_before) {
+	const void *after[SCRATCH_BUFFER_COUNT];
+	_get_scratch_buffers(after);
+	for (int i = 0; i < SCRATCH_BUFFER_COUNT; i++) {
+		if (after[i] != p_before[i]) {
+			stats.allocations++;
+		}
+	}
+}
+
+Dictionary GDScriptDecomp::get_stats() const {
+	static const char *phase_names[STATS_PHASE_MAX] = {
+		"read_nsec",
+		"identifiers_nsec",
+		"constants_nsec",
+		"tokens_nsec",
+		"emit_nsec",
+		"write_nsec",
+	};
+	Dictionary d;
+	uint64_t total = 0;
+	for (int i = 0; i < STATS_PHASE_MAX; i++) {
+		d[phase_names[i]] = stats.phase_nsec[i];
+		total += stats.phase_nsec[i];
+	}
+	d["total_nsec"] = total;
+	d["scripts"] = stats.scripts;
+	d["identifiers"] = stats.identifiers;
+	d["constants"] = stats.constants;
+	d["tokens"] = stats.tokens;
+	d["input_bytes"] = stats.input_bytes;
+	d["output_bytes"] = stats.output_bytes;
+	d["allocations"] = stats.allocations;
+	return d;
+}
+
+void GDScriptDecomp::reset_stats() {
+	stats = DecompStats();
+}
+
+String GDScriptDecomp::get_decompiler_id() const {
+	String id = String(get_class_name()) + ":" + itos(DECOMPILER_REVISION);
+	if (preserve_line_numbers) {
+		id += ":lines";
+	}
+	return id;
+}
+
+String GDScriptDecomp::IdentifierTable::get_string(uint32_t p_idx) const {
+	String s;
+	s.parse_utf8(get_data(p_idx), get_length(p_idx));
+	return s;
+}
+
+void GDScriptDecomp::_decode_identifier_block(char *r_dst, const uint8_t *p_src, uint32_t p_len) {
+	// Word at a time, the compiler vectorizes this where it can
+	const uint64_t mask = 0xb6b6b6b6b6b6b6b6ULL;
+	uint32_t i = 0;
+	for (; i + 8 <= p_len; i += 8) {
+		uint64_t w;
+		memcpy(&w, p_src + i, 8);
+		w ^= mask;
+		memcpy(r_dst + i, &w, 8);
+	}
+	for (; i < p_len; i++) {
+		r_dst[i] = p_src[i] ^ 0xb6;
+	}
+}
+
+void GDScriptDecomp::ConstantTable::reset() {
+	text.clear();
+	entries.resize(values.size());
+	for (uint32_t i = 0; i < entries.size(); i++) {
+		entries[i].len = NOT_RENDERED;
+	}
+}
+
+void GDScriptDecomp::_render_constant(uint32_t p_idx) {
+	CharString utf8 = get_constant_string(constants.values, p_idx).utf8();
+	ConstantTable::Entry &e = constants.entries[p_idx];
+	e.ofs = constants.text.size();
+	e.len = utf8.length();
+	constants.text.resize(e.ofs + e.len);
+	memcpy(constants.text.ptr() + e.ofs, utf8.get_data(), e.len);
+}
+
+Error GDScriptDecomp::_load_bytecode(const uint8_t *p_buffer, size_t p_len, IdentifierTable &r_identifiers, Vector<Variant> &r_constants, TokenStream *r_tokens) {
+	uint64_t ticks = _get_ticks_nsec();
+	const int bytecode_version = get_bytecode_version();
+	const int variant_ver_major = get_variant_ver_major();
+
+	const uint8_t *buf = p_buffer;
+	ERR_FAIL_COND_V(!buf || p_len < 24 || p_len > INT_MAX, ERR_INVALID_DATA);
+	ERR_FAIL_COND_V(buf[0] != 'G' || buf[1] != 'D' || buf[2] != 'S' || buf[3] != 'C', ERR_INVALID_DATA);
+	int total_len = p_len;
+
+	int version = decode_uint32(&buf[4]);
+	if (version != bytecode_version) {
+		ERR_FAIL_COND_V(version > bytecode_version, ERR_INVALID_DATA);
+	}
+	int identifier_count = decode_uint32(&buf[8]);
+	int constant_count = decode_uint32(&buf[12]);
+	int line_count = decode_uint32(&buf[16]);
+	int token_count = decode_uint32(&buf[20]);
+
+	const uint8_t *b = &buf[24];
+	total_len -= 24;
+	ERR_FAIL_COND_V(identifier_count < 0 || constant_count < 0 || line_count < 0 || token_count < 0, ERR_INVALID_DATA);
+	ERR_FAIL_COND_V(identifier_count > total_len / 4, ERR_INVALID_DATA);
+
+	// Find the extent of the identifier block first, so it can be decoded in one pass
+	r_identifiers.entries.resize(identifier_count);
+	uint32_t block_len = 0;
+	for (int i = 0; i < identifier_count; i++) {
+		ERR_FAIL_COND_V(total_len < 4, ERR_INVALID_DATA);
+		uint32_t len = decode_uint32(b + block_len);
+		ERR_FAIL_COND_V(len > (uint32_t)total_len - 4, ERR_INVALID_DATA);
+		r_identifiers.entries[i].ofs = block_len + 4;
+		r_identifiers.entries[i].len = len;
+		block_len += len + 4;
+		total_len -= len + 4;
+	}
+
+	r_identifiers.data.resize(block_len);
+	_decode_identifier_block(r_identifiers.data.ptr(), b, block_len);
+	for (int i = 0; i < identifier_count; i++) {
+		// Identifiers are NUL padded, the last byte is always a terminator
+		IdentifierTable::Entry &e = r_identifiers.entries[i];
+		uint32_t max_len = e.len > 0 ? e.len - 1 : 0;
+		const char *str = r_identifiers.data.ptr() + e.ofs;
+		const char *end = (const char *)memchr(str, 0, max_len);
+		e.len = end ? end - str : max_len;
+	}
+	b += block_len;
+	stats.identifiers += identifier_count;
+	_stats_lap(STATS_IDENTIFIERS, ticks);
+
+	r_constants.resize(constant_count);
+	for (int i = 0; i < constant_count; i++) {
+		Variant v;
+		int len;
+		Error err;
+		if (variant_ver_major == 2) {
+			err = decode_variant_2(v, b, total_len, &len);
+		} else {
+			err = decode_variant_3(v, b, total_len, &len);
+		}
+		if (err) {
+			error_message = RTR("Invalid constant");
+			return err;
+		}
+		b += len;
+		total_len -= len;
+		r_constants.write[i] = v;
+	}
+	stats.constants += constant_count;
+	_stats_lap(STATS_CONSTANTS, ticks);
+	if (!r_tokens) {
+		return OK;
+	}
+
+	ERR_FAIL_COND_V(line_count > total_len / 8, ERR_INVALID_DATA);
+
+	// Spread after the tokens are known
+	const uint8_t *line_block = b;
+	b += line_count * 8;
+	total_len -= line_count * 8;
+
+	// Map local token ids once here, so consumers only deal with GlobalToken
+	const GlobalToken *token_table = get_token_table();
+	const uint32_t token_table_size = get_token_count();
+	uint8_t token_map[TOKEN_MASK + 1];
+	for (uint32_t i = 0; i <= TOKEN_MASK; i++) {
+		token_map[i] = i < token_table_size ? token_table[i] : G_TK_MAX;
+	}
+
+	// Every token takes at least a byte, so a corrupt header can't size the token arrays
+	ERR_FAIL_COND_V(token_count > total_len, ERR_INVALID_DATA);
+	r_tokens->kinds.resize(token_count);
+	r_tokens->payloads.resize(token_count);
+	uint8_t *kinds = r_tokens->kinds.ptr();
+	uint32_t *payloads = r_tokens->payloads.ptr();
+
+	int i = 0;
+	while (i < token_count) {
+		// Most tokens are a single byte, take runs of eight of them at once
+		if (token_count - i >= 8 && total_len >= 8) {
+			uint64_t w;
+			memcpy(&w, b, 8);
+			if (!(w & 0x8080808080808080ULL)) {
+				for (int j = 0; j < 8; j++) {
+					kinds[i + j] = token_map[b[j]];
+					payloads[i + j] = 0;
+				}
+				i += 8;
+				b += 8;
+				total_len -= 8;
+				continue;
+			}
+		}
+
+		ERR_FAIL_COND_V(total_len < 1, ERR_INVALID_DATA);
+
+		if ((*b) & TOKEN_BYTE_MASK) { //little endian always
+			ERR_FAIL_COND_V(total_len < 4, ERR_INVALID_DATA);
+
+			uint32_t token = decode_uint32(b) & ~TOKEN_BYTE_MASK;
+			kinds[i] = token_map[token & TOKEN_MASK];
+			payloads[i] = token >> TOKEN_BITS;
+			b += 4;
+			total_len -= 4;
+		} else {
+			kinds[i] = token_map[*b];
+			payloads[i] = 0;
+			b += 1;
+			total_len--;
+		}
+		i++;
+	}
+
+	// Line entries mark the first token of every line, Godot writes them sorted by token
+	r_tokens->lines.resize(token_count);
+	uint32_t *lines = r_tokens->lines.ptr();
+	uint32_t t = 0;
+	uint32_t linecol = 0;
+	for (int k = 0; k < line_count; k++) {
+		uint32_t token = decode_uint32(line_block + k * 8);
+		if (token < t) {
+			WARN_PRINT("Line table out of order, ignoring line information");
+			t = 0;
+			linecol = 0;
+			break;
+		}
+		for (; t < token && t < (uint32_t)token_count; t++) {
+			lines[t] = linecol;
+		}
+		linecol = decode_uint32(line_block + k * 8 + 4);
+	}
+	for (; t < (uint32_t)token_count; t++) {
+		lines[t] = linecol;
+	}
+	stats.tokens += token_count;
+	_stats_lap(STATS_TOKENS, ticks);
+
+	return OK;
+}
+
+Error GDScriptDecomp::test_bytecode(const Vector<uint8_t> &p_buffer, int &r_valid_tokens, int &r_total_tokens) {
+	const int func_count = get_function_count();
+	const int type_count = get_variant_ver_major() == 2 ? V2Type::VARIANT_MAX : V3Type::VARIANT_MAX;
+
+	r_valid_tokens = 0;
+	r_total_tokens = 0;
+	Error err = _load_bytecode(p_buffer.ptr(), p_buffer.size(), identifiers, constants.values, &tokens);
+	if (err) {
+		return err;
+	}
+
+	// Decoding with the wrong token table produces a stream that breaks simple grammar rules,
+	// count how many tokens fit in their context
+	int indent = 0;
+	int bracket_depth = 0;
+	GlobalToken prev_token = G_TK_NEWLINE;
+	GlobalToken last_token = G_TK_NEWLINE; // last token that isn't a newline
+	const uint32_t token_count = tokens.size();
+	const uint8_t *kinds = tokens.kinds.ptr();
+	const uint32_t *payloads = tokens.payloads.ptr();
+	for (uint32_t i = 0; i < token_count; i++) {
+		GlobalToken curr_token = (GlobalToken)kinds[i];
+		uint32_t payload = payloads[i];
+		bool valid = true;
+		switch (curr_token) {
+			case G_TK_IDENTIFIER:
+			case G_TK_ANNOTATION: {
+				valid = payload < (uint32_t)identifiers.size();
+			} break;
+			case G_TK_CONSTANT: {
+				valid = payload < (uint32_t)constants.size();
+			} break;
+			case G_TK_BUILT_IN_TYPE: {
+				valid = payload < (uint32_t)type_count;
+			} break;
+			case G_TK_BUILT_IN_FUNC: {
+				valid = payload < (uint32_t)func_count;
+			} break;
+			case G_TK_CF_ELIF:
+			case G_TK_CF_FOR:
+			case G_TK_CF_WHILE:
+			case G_TK_CF_BREAK:
+			case G_TK_CF_CONTINUE:
+			case G_TK_CF_PASS:
+			case G_TK_CF_RETURN:
+			case G_TK_CF_MATCH:
+			case G_TK_PR_CLASS_NAME:
+			case G_TK_PR_TOOL:
+			case G_TK_PR_CONST:
+			case G_TK_PR_SIGNAL: {
+				// Statements, these only start a line
+				valid = prev_token == G_TK_NEWLINE || prev_token == G_TK_COLON || prev_token == G_TK_SEMICOLON;
+			} break;
+			case G_TK_PARENTHESIS_OPEN:
+			case G_TK_BRACKET_OPEN:
+			case G_TK_CURLY_BRACKET_OPEN: {
+				bracket_depth++;
+			} break;
+			case G_TK_PARENTHESIS_CLOSE:
+			case G_TK_BRACKET_CLOSE:
+			case G_TK_CURLY_BRACKET_CLOSE: {
+				valid = bracket_depth > 0;
+				bracket_depth = MAX(bracket_depth - 1, 0);
+			} break;
+			case G_TK_NEWLINE: {
+				// A block can only be opened after a colon, one level at a time.
+				// Newlines inside brackets carry the indentation of continuation lines.
+				if (bracket_depth == 0 && (int)payload > indent) {
+					valid = last_token == G_TK_COLON && (int)payload == indent + 1;
+				}
+				if (bracket_depth == 0) {
+					indent = payload;
+				}
+			} break;
+			case G_TK_EOF: {
+				valid = i == token_count - 1;
+			} break;
+			case G_TK_ERROR:
+			case G_TK_CURSOR:
+			case G_TK_MAX: {
+				valid = false;
+			} break;
+			default: {
+			} break;
+		}
+		if (prev_token == G_TK_BUILT_IN_FUNC) {
+			valid = valid && curr_token == G_TK_PARENTHESIS_OPEN;
+		} else if (prev_token == G_TK_PERIOD) {
+			valid = valid && (curr_token == G_TK_IDENTIFIER || curr_token == G_TK_BUILT_IN_FUNC || curr_token == G_TK_BUILT_IN_TYPE);
+		}
+		if (valid) {
+			r_valid_tokens++;
+		}
+		prev_token = curr_token;
+		if (curr_token != G_TK_NEWLINE) {
+			last_token = curr_token;
+		}
+	}
+	r_total_tokens = token_count;
+
+	return OK;
+}
+
+Error GDScriptDecomp::decompile_buffer(const Vector<uint8_t> &p_buffer) {
+	return decompile_span(p_buffer.ptr(), p_buffer.size());
+}
+
+Error GDScriptDecomp::decompile_span(const uint8_t *p_data, size_t p_len) {
+	//Cleanup
+	script_buffer.clear();
 	error_message = RTR("No error");
 
-	return decompile_buffer(bytecode);
+	const int func_count = get_function_count();
+	const int variant_ver_major = get_variant_ver_major();
+	const void *scratch_buffers[SCRATCH_BUFFER_COUNT];
+	_get_scratch_buffers(scratch_buffers);
+
+	//Load bytecode
+	Error err = _load_bytecode(p_data, p_len, identifiers, constants.values, &tokens);
+	if (err) {
+		return err;
+	}
+	constants.reset();
+	uint64_t ticks = _get_ticks_nsec();
+	uint64_t write_nsec = stats.phase_nsec[STATS_WRITE];
+
+	//Decompile script
+	GDScriptTextBuffer &text = script_buffer;
+	int indent = 0;
+	uint32_t out_line = 1;
+	if (preserve_line_numbers && tokens.size() > 0) {
+		for (; out_line < tokens.get_line(0); out_line++) {
+			text.end_line();
+		}
+	}
+	text.begin_line(indent);
+
+	GlobalToken prev_token = G_TK_NEWLINE;
+	int paren_depth = 0;
+	int annotation_paren = -1; // depth of the argument list of the current annotation
+	const uint32_t token_count = tokens.size();
+	const uint8_t *kinds = tokens.kinds.ptr();
+	const uint32_t *payloads = tokens.payloads.ptr();
+	// Annotations and their arguments are separated from whatever they annotate on the same line
+	auto annotation_end = [&](uint32_t p_next) {
+		if (p_next < token_count && kinds[p_next] != G_TK_NEWLINE && kinds[p_next] != G_TK_PR_VAR) {
+			text.append(' ');
+		}
+	};
+	for (uint32_t i = 0; i < token_count; i++) {
+		// Unknown tokens come out as G_TK_MAX and are skipped, same as TK_ERROR and friends
+		GlobalToken curr_token = (GlobalToken)kinds[i];
+		switch (curr_token) {
+			case G_TK_EMPTY: {
+				//skip
+			} break;
+			case G_TK_IDENTIFIER: {
+				uint32_t identifier = payloads[i];
+				ERR_FAIL_COND_V(identifier >= (uint32_t)identifiers.size(), ERR_INVALID_DATA);
+				text.append(identifiers.get_data(identifier), identifiers.get_length(identifier));
+			} break;
+			case G_TK_CONSTANT: {
+				uint32_t constant = payloads[i];
+				ERR_FAIL_COND_V(constant >= constants.size(), ERR_INVALID_DATA);
+				_append_constant(text, constant);
+			} break;
+			case G_TK_SELF: {
+				text.append("self");
+			} break;
+			case G_TK_BUILT_IN_TYPE: {
+				if (variant_ver_major == 2) {
+					text.append(get_type_name_v2(payloads[i]));
+				} else {
+					text.append(get_type_name_v3(payloads[i]));
+				}
+			} break;
+			case G_TK_BUILT_IN_FUNC: {
+				uint32_t func = payloads[i];
+				ERR_FAIL_COND_V(func >= (uint32_t)func_count, ERR_INVALID_DATA);
+				text.append(get_function_name(func));
+			} break;
+			case G_TK_OP_IN: {
+				text.ensure_space();
+				text.append("in ");
+			} break;
+			case G_TK_OP_EQUAL: {
+				text.ensure_space();
+				text.append("== ");
+			} break;
+			case G_TK_OP_NOT_EQUAL: {
+				text.ensure_space();
+				text.append("!= ");
+			} break;
+			case G_TK_OP_LESS: {
+				text.ensure_space();
+				text.append("< ");
+			} break;
+			case G_TK_OP_LESS_EQUAL: {
+				text.ensure_space();
+				text.append("<= ");
+			} break;
+			case G_TK_OP_GREATER: {
+				text.ensure_space();
+				text.append("> ");
+			} break;
+			case G_TK_OP_GREATER_EQUAL: {
+				text.ensure_space();
+				text.append(">= ");
+			} break;
+			case G_TK_OP_AND: {
+				text.ensure_space();
+				text.append("and ");
+			} break;
+			case G_TK_OP_OR: {
+				text.ensure_space();
+				text.append("or ");
+			} break;
+			case G_TK_OP_NOT: {
+				text.ensure_space();
+				text.append("not ");
+			} break;
+			case G_TK_OP_ADD: {
+				text.ensure_space();
+				text.append("+ ");
+			} break;
+			case G_TK_OP_SUB: {
+				text.ensure_space();
+				text.append("- ");
+				//TODO: do not add space after unary "-"
+			} break;
+			case G_TK_OP_MUL: {
+				text.ensure_space();
+				text.append("* ");
+			} break;
+			case G_TK_OP_DIV: {
+				text.ensure_space();
+				text.append("/ ");
+			} break;
+			case G_TK_OP_MOD: {
+				text.ensure_space();
+				text.append("% ");
+			} break;
+			case G_TK_OP_SHIFT_LEFT: {
+				text.ensure_space();
+				text.append("<< ");
+			} break;
+			case G_TK_OP_SHIFT_RIGHT: {
+				text.ensure_space();
+				text.append(">> ");
+			} break;
+			case G_TK_OP_ASSIGN: {
+				text.ensure_space();
+				text.append("= ");
+			} break;
+			case G_TK_OP_ASSIGN_ADD: {
+				text.ensure_space();
+				text.append("+= ");
+			} break;
+			case G_TK_OP_ASSIGN_SUB: {
+				text.ensure_space();
+				text.append("-= ");
+			} break;
+			case G_TK_OP_ASSIGN_MUL: {
+				text.ensure_space();
+				text.append("*= ");
+			} break;
+			case G_TK_OP_ASSIGN_DIV: {
+				text.ensure_space();
+				text.append("/= ");
+			} break;
+			case G_TK_OP_ASSIGN_MOD: {
+				text.ensure_space();
+				text.append("%= ");
+			} break;
+			case G_TK_OP_ASSIGN_SHIFT_LEFT: {
+				text.ensure_space();
+				text.append("<<= ");
+			} break;
+			case G_TK_OP_ASSIGN_SHIFT_RIGHT: {
+				text.ensure_space();
+				text.append(">>= ");
+			} break;
+			case G_TK_OP_ASSIGN_BIT_AND: {
+				text.ensure_space();
+				text.append("&= ");
+			} break;
+			case G_TK_OP_ASSIGN_BIT_OR: {
+				text.ensure_space();
+				text.append("|= ");
+			} break;
+			case G_TK_OP_ASSIGN_BIT_XOR: {
+				text.ensure_space();
+				text.append("^= ");
+			} break;
+			case G_TK_OP_BIT_AND: {
+				text.ensure_space();
+				text.append("& ");
+			} break;
+			case G_TK_OP_BIT_OR: {
+				text.ensure_space();
+				text.append("| ");
+			} break;
+			case G_TK_OP_BIT_XOR: {
+				text.ensure_space();
+				text.append("^ ");
+			} break;
+			case G_TK_OP_BIT_INVERT: {
+				text.ensure_space();
+				text.append("~ ");
+			} break;
+			case G_TK_CF_IF: {
+				if (prev_token != G_TK_NEWLINE) {
+					text.ensure_space();
+				}
+				text.append("if ");
+			} break;
+			case G_TK_CF_ELIF: {
+				text.append("elif ");
+			} break;
+			case G_TK_CF_ELSE: {
+				if (prev_token != G_TK_NEWLINE) {
+					text.ensure_space();
+				}
+				text.append("else ");
+			} break;
+			case G_TK_CF_FOR: {
+				text.append("for ");
+			} break;
+			case G_TK_CF_DO: {
+				text.append("do ");
+			} break;
+			case G_TK_CF_WHILE: {
+				text.append("while ");
+			} break;
+			case G_TK_CF_SWITCH: {
+				text.append("switch ");
+			} break;
+			case G_TK_CF_CASE: {
+				text.append("case ");
+			} break;
+			case G_TK_CF_BREAK: {
+				text.append("break");
+			} break;
+			case G_TK_CF_CONTINUE: {
+				text.append("continue");
+			} break;
+			case G_TK_CF_PASS: {
+				text.append("pass");
+			} break;
+			case G_TK_CF_RETURN: {
+				text.append("return ");
+			} break;
+			case G_TK_CF_MATCH: {
+				text.append("match ");
+			} break;
+			case G_TK_PR_FUNCTION: {
+				text.append("func ");
+			} break;
+			case G_TK_PR_CLASS: {
+				text.append("class ");
+			} break;
+			case G_TK_PR_CLASS_NAME: {
+				text.append("class_name ");
+			} break;
+			case G_TK_PR_EXTENDS: {
+				if (prev_token != G_TK_NEWLINE) {
+					text.ensure_space();
+				}
+				text.append("extends ");
+			} break;
+			case G_TK_PR_IS: {
+				text.ensure_space();
+				text.append("is ");
+			} break;
+			case G_TK_PR_ONREADY: {
+				text.append("onready ");
+			} break;
+			case G_TK_PR_TOOL: {
+				text.append("tool ");
+			} break;
+			case G_TK_PR_STATIC: {
+				text.append("static ");
+			} break;
+			case G_TK_PR_EXPORT: {
+				text.append("export ");
+			} break;
+			case G_TK_PR_SETGET: {
+				text.append(" setget ");
+			} break;
+			case G_TK_PR_CONST: {
+				text.append("const ");
+			} break;
+			case G_TK_PR_VAR: {
+				if (!text.is_line_empty()) {
+					text.append(' ');
+				}
+				text.append("var ");
+			} break;
+			case G_TK_PR_AS: {
+				text.ensure_space();
+				text.append("as ");
+			} break;
+			case G_TK_PR_VOID: {
+				text.append("void ");
+			} break;
+			case G_TK_PR_ENUM: {
+				text.append("enum ");
+			} break;
+			case G_TK_PR_PRELOAD: {
+				text.append("preload");
+			} break;
+			case G_TK_PR_ASSERT: {
+				text.append("assert ");
+			} break;
+			case G_TK_PR_YIELD: {
+				text.append("yield ");
+			} break;
+			case G_TK_PR_SIGNAL: {
+				text.append("signal ");
+			} break;
+			case G_TK_PR_BREAKPOINT: {
+				text.append("breakpoint ");
+			} break;
+			case G_TK_PR_REMOTE: {
+				text.append("remote ");
+			} break;
+			case G_TK_PR_SYNC: {
+				text.append("sync ");
+			} break;
+			case G_TK_PR_MASTER: {
+				text.append("master ");
+			} break;
+			case G_TK_PR_SLAVE: {
+				text.append("slave ");
+			} break;
+			case G_TK_PR_PUPPET: {
+				text.append("puppet ");
+			} break;
+			case G_TK_PR_REMOTESYNC: {
+				text.append("remotesync ");
+			} break;
+			case G_TK_PR_MASTERSYNC: {
+				text.append("mastersync ");
+			} break;
+			case G_TK_PR_SLAVESYNC: {
+				text.append("slavesync ");
+			} break;
+			case G_TK_PR_PUPPETSYNC: {
+				text.append("puppetsync ");
+			} break;
+			case G_TK_BRACKET_OPEN: {
+				text.append("[");
+			} break;
+			case G_TK_BRACKET_CLOSE: {
+				text.append("]");
+			} break;
+			case G_TK_CURLY_BRACKET_OPEN: {
+				text.append("{");
+			} break;
+			case G_TK_CURLY_BRACKET_CLOSE: {
+				text.append("}");
+			} break;
+			case G_TK_PARENTHESIS_OPEN: {
+				paren_depth++;
+				if (prev_token == G_TK_ANNOTATION) {
+					annotation_paren = paren_depth;
+				}
+				text.append("(");
+			} break;
+			case G_TK_PARENTHESIS_CLOSE: {
+				text.append(")");
+				if (paren_depth == annotation_paren) {
+					annotation_paren = -1;
+					annotation_end(i + 1);
+				}
+				paren_depth = MAX(paren_depth - 1, 0);
+			} break;
+			case G_TK_COMMA: {
+				text.append(", ");
+			} break;
+			case G_TK_SEMICOLON: {
+				text.append(";");
+			} break;
+			case G_TK_PERIOD: {
+				text.append(".");
+			} break;
+			case G_TK_QUESTION_MARK: {
+				text.append("?");
+			} break;
+			case G_TK_COLON: {
+				text.append(":");
+			} break;
+			case G_TK_DOLLAR: {
+				text.append("$");
+			} break;
+			case G_TK_FORWARD_ARROW: {
+				text.append("->");
+			} break;
+			case G_TK_NEWLINE: {
+				text.end_line();
+				out_line++;
+				if (preserve_line_numbers && i + 1 < token_count) {
+					for (; out_line < tokens.get_line(i + 1); out_line++) {
+						text.end_line();
+					}
+				}
+				indent = payloads[i];
+				text.begin_line(indent);
+			} break;
+			case G_TK_CONST_PI: {
+				text.append("PI");
+			} break;
+			case G_TK_CONST_TAU: {
+				text.append("TAU");
+			} break;
+			case G_TK_WILDCARD: {
+				text.append("_");
+			} break;
+			case G_TK_CONST_INF: {
+				text.append("INF");
+			} break;
+			case G_TK_CONST_NAN: {
+				text.append("NAN");
+			} break;
+			case G_TK_ANNOTATION: {
+				uint32_t identifier = payloads[i];
+				ERR_FAIL_COND_V(identifier >= (uint32_t)identifiers.size(), ERR_INVALID_DATA);
+				text.append(identifiers.get_data(identifier), identifiers.get_length(identifier));
+				if (i + 1 < token_count && kinds[i + 1] != G_TK_PARENTHESIS_OPEN) {
+					annotation_end(i + 1);
+				}
+			} break;
+			case G_TK_OP_POW: {
+				text.ensure_space();
+				text.append("** ");
+			} break;
+			case G_TK_OP_ASSIGN_POW: {
+				text.ensure_space();
+				text.append("**= ");
+			} break;
+			case G_TK_CF_WHEN: {
+				text.ensure_space();
+				text.append("when ");
+			} break;
+			case G_TK_PR_AWAIT: {
+				text.append("await ");
+			} break;
+			case G_TK_PR_NAMESPACE: {
+				text.append("namespace ");
+			} break;
+			case G_TK_PR_SUPER: {
+				text.append("super");
+			} break;
+			case G_TK_PR_TRAIT: {
+				text.append("trait ");
+			} break;
+			case G_TK_PERIOD_PERIOD: {
+				text.append("..");
+			} break;
+			case G_TK_ERROR:
+			case G_TK_EOF:
+			case G_TK_CURSOR:
+			case G_TK_MAX: {
+				//skip - invalid
+			} break;
+		}
+		prev_token = curr_token;
+	}
+
+	text.discard_empty_line();
+	if (!text.is_line_empty()) {
+		text.end_line();
+	}
+	text.flush();
+
+	_stats_lap(STATS_EMIT, ticks);
+	// The sink keeps its own time
+	stats.phase_nsec[STATS_EMIT] -= stats.phase_nsec[STATS_WRITE] - write_nsec;
+	_count_reallocations(scratch_buffers);
+	stats.scripts++;
+	stats.input_bytes += p_len;
+	stats.output_bytes += text.get_total_size();
+
+	if (text.get_total_size() == 0) {
+		error_message = RTR("Invalid token");
+		return ERR_INVALID_DATA;
+	}
+
+	return OK;
 }
 
 String GDScriptDecomp::get_script_text() {
-	return script_text;
+	return script_buffer.as_string();
+}
+
+const GDScriptTextBuffer &GDScriptDecomp::get_script_buffer() const {
+	return script_buffer;
 }
 
 String GDScriptDecomp::get_error_message() {
 	return error_message;
 }
 
+String GDScriptDecomp::get_failure_message(Error p_err) {
+	if (p_err == ERR_FILE_CANT_OPEN || p_err == ERR_FILE_CANT_WRITE) {
+		return RTR("FileAccess error");
+	}
+	// Most checks of the loaders fail through ERR_FAIL_COND_V, without a message of their own
+	if (error_message == RTR("No error")) {
+		return RTR("Invalid bytecode") + " (" + String(error_names[p_err]) + ")";
+	}
+	return error_message;
+}
+
 String GDScriptDecomp::get_constant_string(Vector<Variant> &constants, uint32_t constId) {
 	String constString = constants[constId].get_construct_string();
 	if (constants[constId].get_type() == Variant::Type::STRING) {
@@ -5,9 +5,22 @@
 #ifndef GDSCRIPT_DECOMP_H
 #define GDSCRIPT_DECOMP_H
 
+#include "bytecode_cache.h"
+#include "core/crypto/crypto_core.h"
+#include "core/io/file_access.h"
 #include "core/object/class_db.h"
 #include "core/object/object.h"
+#include "core/object/worker_thread_pool.h"
+#include "core/templates/hash_map.h"
+#include "core/templates/local_vector.h"
 #include "core/templates/rb_map.h"
+#include "core/templates/safe_refcount.h"
+
+// Header flags of encoded variants, private to core/io/marshalls.cpp
+#define ENCODE_MASK 0xFF
+#define ENCODE_FLAG_64 (1 << 16)
+#define ENCODE_FLAG_OBJECT_AS_ID (1 << 16)
+
 namespace V2Type {
 enum Type {
 
@@ -92,23 +105,523 @@ enum Type {
 	VARIANT_MAX
 };
 }
+// Append-only UTF-8 output for the emitter. Keeps its capacity between scripts
+// and is only converted to a String when someone asks for one.
+// With a sink set, finished lines are handed over in chunks instead of being kept.
+class GDScriptTextBuffer {
+public:
+	typedef void (*SinkFunc)(void *p_userdata, const char *p_data, uint32_t p_len);
+
+private:
+	enum {
+		SINK_CHUNK_SIZE = 4096,
+	};
+
+	LocalVector<char> data;
+	uint32_t line_begin = 0; // before the indentation
+	uint32_t line_start = 0; // after the indentation
+	uint64_t flushed_size = 0;
+	SinkFunc sink_func = nullptr;
+	void *sink_userdata = nullptr;
+
+public:
+	_FORCE_INLINE_ void clear() {
+		data.clear();
+		line_begin = 0;
+		line_start = 0;
+		flushed_size = 0;
+	}
+	_FORCE_INLINE_ uint32_t size() const { return data.size(); }
+	_FORCE_INLINE_ const char *ptr() const { return data.ptr(); }
+	_FORCE_INLINE_ bool is_line_empty() const { return data.size() == line_start; }
+	// Includes whatever was already handed to the sink
+	_FORCE_INLINE_ uint64_t get_total_size() const { return flushed_size + data.size(); }
+
+	void set_sink(SinkFunc p_func, void *p_userdata) {
+		sink_func = p_func;
+		sink_userdata = p_userdata;
+	}
+	void flush() {
+		if (sink_func && data.size()) {
+			sink_func(sink_userdata, data.ptr(), data.size());
+			flushed_size += data.size();
+			data.clear();
+			line_begin = 0;
+			line_start = 0;
+		}
+	}
+
+	_FORCE_INLINE_ void append(char p_char) {
+		data.push_back(p_char);
+	}
+	_FORCE_INLINE_ void append(const char *p_str, uint32_t p_len) {
+		uint32_t ofs = data.size();
+		data.resize(ofs + p_len);
+		memcpy(data.ptr() + ofs, p_str, p_len);
+	}
+	_FORCE_INLINE_ void append(const char *p_str) {
+		append(p_str, strlen(p_str));
+	}
+	void append(const String &p_str) {
+		const char32_t *src = p_str.get_data();
+		int len = p_str.length();
+		for (int i = 0; i < len; i++) {
+			if (src[i] >= 0x80) {
+				CharString utf8 = p_str.utf8();
+				append(utf8.get_data(), utf8.length());
+				return;
+			}
+		}
+		uint32_t ofs = data.size();
+		data.resize(ofs + len);
+		char *dst = data.ptr() + ofs;
+		for (int i = 0; i < len; i++) {
+			dst[i] = (char)src[i];
+		}
+	}
+
+	// Separates operators from the previous token, an empty line counts as needing one
+	_FORCE_INLINE_ void ensure_space() {
+		if (is_line_empty() || data[data.size() - 1] != ' ') {
+			data.push_back(' ');
+		}
+	}
+	_FORCE_INLINE_ void begin_line(int p_indent) {
+		// Only whole lines are flushed, the emitter still looks at the current one
+		if (sink_func && data.size() >= SINK_CHUNK_SIZE) {
+			flush();
+		}
+		line_begin = data.size();
+		for (int i = 0; i < p_indent; i++) {
+			data.push_back('\t');
+		}
+		line_start = data.size();
+	}
+	_FORCE_INLINE_ void end_line() {
+		data.push_back('\n');
+	}
+	// Drops the indentation of a trailing line that got no tokens
+	_FORCE_INLINE_ void discard_empty_line() {
+		if (is_line_empty()) {
+			data.resize(line_begin);
+			line_start = line_begin;
+		}
+	}
+
+	String as_string() const {
+		String ret;
+		if (data.size()) {
+			ret.parse_utf8(data.ptr(), data.size());
+		}
+		return ret;
+	}
+};
+
+// AES-256 key schedule for encrypted (.gde) scripts, set up once per key.
+// Files are decrypted in place into the caller's buffer, so one context can be shared by all workers.
+class GDScriptDecryptContext {
+	enum {
+		HEADER_MAGIC = 0x43454447, // "GDEC"
+		HEADER_SIZE = 4 + 16 + 8 + 16, // magic, MD5, length, IV
+	};
+
+	// mbedtls only reads the key schedule when decrypting
+	mutable CryptoCore::AESContext aes;
+	bool key_set = false;
+
+public:
+	Error set_key(const Vector<uint8_t> &p_key);
+	bool is_key_set() const { return key_set; }
+	Error decrypt_file(const String &p_path, LocalVector<uint8_t> &r_buffer, uint64_t &r_len) const;
+};
+
+// Progress of a batch running on the worker thread pool. Workers count the files they're done with,
+// the thread that started the batch polls the count and can cancel the files that aren't started yet.
+struct GDScriptBatchProgress {
+	// Returns true to cancel
+	typedef bool (*Func)(void *p_userdata, int p_done, int p_total);
+	enum {
+		POLL_INTERVAL_USEC = 50000,
+	};
+
+	Func func = nullptr;
+	void *userdata = nullptr;
+	SafeNumeric<uint32_t> done;
+	SafeFlag cancelled;
+
+	// Same as WorkerThreadPool::wait_for_group_task_completion(), calls func in between when there's one
+	void wait(WorkerThreadPool::GroupID p_group, int p_total);
+};
+
 class GDScriptDecomp : public Object {
 	GDCLASS(GDScriptDecomp, Object);
 
+	friend class GDScriptBytecodeWriter;
+
+public:
+	// Union of the tokens of every supported bytecode version.
+	// Versioned decompilers map their own token ids onto these.
+	enum GlobalToken {
+		G_TK_EMPTY,
+		G_TK_IDENTIFIER,
+		G_TK_CONSTANT,
+		G_TK_SELF,
+		G_TK_BUILT_IN_TYPE,
+		G_TK_BUILT_IN_FUNC,
+		G_TK_OP_IN,
+		G_TK_OP_EQUAL,
+		G_TK_OP_NOT_EQUAL,
+		G_TK_OP_LESS,
+		G_TK_OP_LESS_EQUAL,
+		G_TK_OP_GREATER,
+		G_TK_OP_GREATER_EQUAL,
+		G_TK_OP_AND,
+		G_TK_OP_OR,
+		G_TK_OP_NOT,
+		G_TK_OP_ADD,
+		G_TK_OP_SUB,
+		G_TK_OP_MUL,
+		G_TK_OP_DIV,
+		G_TK_OP_MOD,
+		G_TK_OP_SHIFT_LEFT,
+		G_TK_OP_SHIFT_RIGHT,
+		G_TK_OP_ASSIGN,
+		G_TK_OP_ASSIGN_ADD,
+		G_TK_OP_ASSIGN_SUB,
+		G_TK_OP_ASSIGN_MUL,
+		G_TK_OP_ASSIGN_DIV,
+		G_TK_OP_ASSIGN_MOD,
+		G_TK_OP_ASSIGN_SHIFT_LEFT,
+		G_TK_OP_ASSIGN_SHIFT_RIGHT,
+		G_TK_OP_ASSIGN_BIT_AND,
+		G_TK_OP_ASSIGN_BIT_OR,
+		G_TK_OP_ASSIGN_BIT_XOR,
+		G_TK_OP_BIT_AND,
+		G_TK_OP_BIT_OR,
+		G_TK_OP_BIT_XOR,
+		G_TK_OP_BIT_INVERT,
+		G_TK_CF_IF,
+		G_TK_CF_ELIF,
+		G_TK_CF_ELSE,
+		G_TK_CF_FOR,
+		G_TK_CF_DO, // removed in 3.1
+		G_TK_CF_WHILE,
+		G_TK_CF_SWITCH, // removed in 3.1
+		G_TK_CF_CASE, // removed in 3.1
+		G_TK_CF_BREAK,
+		G_TK_CF_CONTINUE,
+		G_TK_CF_PASS,
+		G_TK_CF_RETURN,
+		G_TK_CF_MATCH,
+		G_TK_PR_FUNCTION,
+		G_TK_PR_CLASS,
+		G_TK_PR_CLASS_NAME,
+		G_TK_PR_EXTENDS,
+		G_TK_PR_IS,
+		G_TK_PR_ONREADY,
+		G_TK_PR_TOOL,
+		G_TK_PR_STATIC,
+		G_TK_PR_EXPORT,
+		G_TK_PR_SETGET,
+		G_TK_PR_CONST,
+		G_TK_PR_VAR,
+		G_TK_PR_AS,
+		G_TK_PR_VOID,
+		G_TK_PR_ENUM,
+		G_TK_PR_PRELOAD,
+		G_TK_PR_ASSERT,
+		G_TK_PR_YIELD,
+		G_TK_PR_SIGNAL,
+		G_TK_PR_BREAKPOINT,
+		G_TK_PR_REMOTE,
+		G_TK_PR_SYNC,
+		G_TK_PR_MASTER,
+		G_TK_PR_SLAVE,
+		G_TK_PR_PUPPET,
+		G_TK_PR_REMOTESYNC,
+		G_TK_PR_MASTERSYNC,
+		G_TK_PR_SLAVESYNC, // renamed to PUPPETSYNC in 3.1
+		G_TK_PR_PUPPETSYNC,
+		G_TK_BRACKET_OPEN,
+		G_TK_BRACKET_CLOSE,
+		G_TK_CURLY_BRACKET_OPEN,
+		G_TK_CURLY_BRACKET_CLOSE,
+		G_TK_PARENTHESIS_OPEN,
+		G_TK_PARENTHESIS_CLOSE,
+		G_TK_COMMA,
+		G_TK_SEMICOLON,
+		G_TK_PERIOD,
+		G_TK_QUESTION_MARK,
+		G_TK_COLON,
+		G_TK_DOLLAR,
+		G_TK_FORWARD_ARROW,
+		G_TK_NEWLINE,
+		G_TK_CONST_PI,
+		G_TK_CONST_TAU,
+		G_TK_WILDCARD,
+		G_TK_CONST_INF,
+		G_TK_CONST_NAN,
+		G_TK_ERROR,
+		G_TK_EOF,
+		G_TK_CURSOR,
+		// Godot 4
+		G_TK_ANNOTATION,
+		G_TK_OP_POW,
+		G_TK_OP_ASSIGN_POW,
+		G_TK_CF_WHEN,
+		G_TK_PR_AWAIT,
+		G_TK_PR_NAMESPACE,
+		G_TK_PR_SUPER,
+		G_TK_PR_TRAIT,
+		G_TK_PERIOD_PERIOD,
+		G_TK_MAX
+	};
+
 protected:
+	enum {
+		DECOMPILER_REVISION = 2, // Bump when the output changes, invalidates cached scripts
+	};
+
+	enum {
+		TOKEN_BYTE_MASK = 0x80,
+		TOKEN_BITS = 8,
+		TOKEN_MASK = (1 << TOKEN_BITS) - 1,
+		TOKEN_LINE_BITS = 24,
+		TOKEN_LINE_MASK = (1 << TOKEN_LINE_BITS) - 1,
+	};
+
 	static void _bind_methods();
-	static void _ensure_space(String &p_code);
 
-	String script_text;
+	GDScriptTextBuffer script_buffer;
 	String error_message;
 
+	// Identifiers of the loaded script, decoded as UTF-8 into one buffer.
+	// Nothing is allocated per identifier and no StringName is created.
+	struct IdentifierTable {
+		struct Entry {
+			uint32_t ofs = 0;
+			uint32_t len = 0;
+		};
+		LocalVector<char> data;
+		LocalVector<Entry> entries;
+
+		_FORCE_INLINE_ uint32_t size() const { return entries.size(); }
+		_FORCE_INLINE_ const char *get_data(uint32_t p_idx) const { return data.ptr() + entries[p_idx].ofs; }
+		_FORCE_INLINE_ uint32_t get_length(uint32_t p_idx) const { return entries[p_idx].len; }
+		String get_string(uint32_t p_idx) const;
+	};
+
+	// Tokens of the loaded script, already mapped to GlobalToken, with their payloads and
+	// source line/column kept apart
+	struct TokenStream {
+		LocalVector<uint8_t> kinds;
+		LocalVector<uint32_t> payloads;
+		LocalVector<uint32_t> lines; // 0 if unknown, column in the upper bits
+
+		_FORCE_INLINE_ uint32_t get_line(uint32_t p_idx) const { return lines[p_idx] & TOKEN_LINE_MASK; }
+
+		_FORCE_INLINE_ uint32_t size() const { return kinds.size(); }
+	};
+
+	// Constants of the loaded script. Each one is rendered to text the first time it's emitted,
+	// later uses only copy the bytes.
+	struct ConstantTable {
+		enum {
+			NOT_RENDERED = UINT32_MAX,
+		};
+		struct Entry {
+			uint32_t ofs = 0;
+			uint32_t len = NOT_RENDERED;
+		};
+		Vector<Variant> values;
+		LocalVector<char> text;
+		LocalVector<Entry> entries;
+
+		_FORCE_INLINE_ uint32_t size() const { return values.size(); }
+		void reset();
+	};
+
+	// Scratch buffers, reused across calls
+	LocalVector<uint8_t> file_buffer;
+	// Bytes of the last script read, either file_buffer or a view of a mapped pack held by mapped_file
+	const uint8_t *file_data = nullptr;
+	Ref<FileAccess> mapped_file;
+	IdentifierTable identifiers;
+	ConstantTable constants;
+	TokenStream tokens;
+
+	void _render_constant(uint32_t p_idx);
+	_FORCE_INLINE_ void _append_constant(GDScriptTextBuffer &r_text, uint32_t p_idx) {
+		if (unlikely(constants.entries[p_idx].len == ConstantTable::NOT_RENDERED)) {
+			_render_constant(p_idx);
+		}
+		const ConstantTable::Entry &e = constants.entries[p_idx];
+		r_text.append(constants.text.ptr() + e.ofs, e.len);
+	}
+
+	bool preserve_line_numbers = false;
+	Ref<GDScriptDecompCache> cache;
+	GDScriptBatchProgress::Func batch_progress_func = nullptr;
+	void *batch_progress_userdata = nullptr;
+
+public:
+	// Time spent per phase of a script, see get_stats()
+	enum StatsPhase {
+		STATS_READ, // reading and decrypting the file
+		STATS_IDENTIFIERS, // header and identifier table
+		STATS_CONSTANTS,
+		STATS_TOKENS, // tokens and line table
+		STATS_EMIT,
+		STATS_WRITE, // handing the text to the file, not part of STATS_EMIT
+		STATS_PHASE_MAX,
+	};
+
+protected:
+	struct DecompStats {
+		uint64_t phase_nsec[STATS_PHASE_MAX] = {};
+		uint64_t scripts = 0;
+		uint64_t identifiers = 0;
+		uint64_t constants = 0;
+		uint64_t tokens = 0;
+		uint64_t input_bytes = 0;
+		uint64_t output_bytes = 0;
+		uint64_t allocations = 0; // scratch buffers that had to be reallocated
+		void add(const DecompStats &p_other);
+	};
+	DecompStats stats;
+
+	static uint64_t _get_ticks_nsec();
+	_FORCE_INLINE_ void _stats_lap(StatsPhase p_phase, uint64_t &r_ticks) {
+		uint64_t now = _get_ticks_nsec();
+		stats.phase_nsec[p_phase] += now - r_ticks;
+		r_ticks = now;
+	}
+	// The scratch buffers keep their capacity, a buffer that moved was reallocated
+	enum {
+		SCRATCH_BUFFER_COUNT = 8,
+	};
+	void _get_scratch_buffers(const void **r_ptrs) const;
+	void _count_reallocations(const void *const *p_before);
+
+	static void _decode_identifier_block(char *r_dst, const uint8_t *p_src, uint32_t p_len);
+	struct FileSink {
+		FileAccess *file = nullptr;
+		DecompStats *stats = nullptr;
+	};
+	static void _file_sink(void *p_userdata, const char *p_data, uint32_t p_len);
+	Error _read_byte_code(const String &p_path, const GDScriptDecryptContext *p_decrypt, uint64_t &r_len);
+	Error _decompile_byte_code_to_file(const String &p_path, const String &p_target_path, const GDScriptDecryptContext *p_decrypt);
+	Error _hash_byte_code(const String &p_path, const GDScriptDecryptContext *p_decrypt, uint64_t &r_hash);
+	uint64_t _hash_token_stream() const;
+	// Token streams of other formats are converted into the 3.x layout, newlines included, so they share the emitter.
+	// Without r_tokens, loading stops after the identifier and constant tables.
+	virtual Error _load_bytecode(const uint8_t *p_buffer, size_t p_len, IdentifierTable &r_identifiers, Vector<Variant> &r_constants, TokenStream *r_tokens);
+
+	struct BatchDecompileData {
+		uint64_t commit = 0;
+		String decompiler_id;
+		Ref<GDScriptDecompCache> cache;
+		Vector<String> paths;
+		Vector<String> hashes; // MD5 from the pack index, empty if unknown
+		Vector<String> targets;
+		GDScriptDecryptContext decrypt; // shared by all workers
+		bool preserve_line_numbers = false;
+		String *errors = nullptr;
+		uint64_t *token_hashes = nullptr;
+		DecompStats *worker_stats = nullptr; // one per worker, added up once the batch is done
+		SafeNumeric<uint32_t> next_file;
+		GDScriptBatchProgress progress;
+	};
+	String _decompile_batch_file(uint32_t p_index, BatchDecompileData *p_data);
+	void _decompile_files_worker(uint32_t p_worker, BatchDecompileData *p_data);
+	void _hash_files_worker(uint32_t p_worker, BatchDecompileData *p_data);
+	Error _decompile_files(const Vector<String> &p_paths, const Vector<String> &p_hashes, const String &p_output_dir, int p_threads, const Vector<uint8_t> &p_key);
+	static String _get_target_path(const String &p_output_dir, const String &p_path);
+	static void _get_pack_scripts(Vector<String> &r_paths, Vector<String> &r_hashes);
+	Dictionary batch_errors;
+
+	// What an incremental run found for each script of the pack, kept next to the output
+	struct ManifestEntry {
+		String md5;
+		uint64_t token_hash = 0;
+	};
+	enum {
+		MANIFEST_FORMAT_VERSION = 2, // 2: token hashes are MD5 based
+	};
+	static Error _load_manifest(const String &p_path, const String &p_decompiler_id, HashMap<String, ManifestEntry> &r_entries);
+	static Error _save_manifest(const String &p_path, const String &p_decompiler_id, const HashMap<String, ManifestEntry> &p_entries);
+	Dictionary change_report;
+
+	static Array _detect_version(const Vector<uint8_t> &p_buffer);
+	static Array _detect_version_from_files(const Vector<String> &p_paths, int p_max_samples);
+
 public:
-	virtual Error decompile_buffer(Vector<uint8_t> p_buffer) = 0;
+	struct VersionScore {
+		uint64_t commit = 0;
+		float score = 0;
+		int order = 0; // position in decomp_versions, newer versions first
+		bool operator<(const VersionScore &p_other) const {
+			return score != p_other.score ? score > p_other.score : order < p_other.order;
+		}
+	};
+
+	// Per-version tables driving the shared decompiler
+	virtual uint64_t get_commit() const = 0;
+	virtual int get_bytecode_version() const = 0;
+	virtual int get_variant_ver_major() const = 0;
+	virtual const GlobalToken *get_token_table() const = 0;
+	virtual int get_token_count() const = 0;
+	virtual const char *get_function_name(int p_func) const = 0;
+	virtual int get_function_count() const = 0;
+
+	virtual Error decompile_span(const uint8_t *p_data, size_t p_len);
+	Error decompile_buffer(const Vector<uint8_t> &p_buffer);
+	Error test_bytecode(const Vector<uint8_t> &p_buffer, int &r_valid_tokens, int &r_total_tokens);
+
+	// Implemented in bytecode_versions.cpp, they need to know about every version
+	static GDScriptDecomp *create(const Variant &p_commit_or_version);
+	static Vector<VersionScore> detect_version(const Vector<uint8_t> &p_buffer);
+	static Vector<VersionScore> detect_version_from_files(const Vector<String> &p_paths, int p_max_samples = 8);
 	Error decompile_byte_code_encrypted(const String &p_path, Vector<uint8_t> p_key);
 	Error decompile_byte_code(const String &p_path);
 
+	// Identifier names and string constants of a script, read without decoding its tokens.
+	// Symbols used more than once in the script may be listed more than once.
+	Error load_script_symbols(const String &p_path, const GDScriptDecryptContext *p_decrypt, Vector<String> &r_symbols);
+
+	// Stream the output instead of keeping it, get_script_text() is empty afterwards
+	Error decompile_span_to_sink(const uint8_t *p_data, size_t p_len, GDScriptTextBuffer::SinkFunc p_func, void *p_userdata);
+	Error decompile_byte_code_to_file(const String &p_path, const String &p_target_path, const Vector<uint8_t> &p_key = Vector<uint8_t>());
+
+	Error decompile_files(const Vector<String> &p_paths, const String &p_output_dir, int p_threads = -1, const Vector<uint8_t> &p_key = Vector<uint8_t>());
+	Error decompile_pack_files(const String &p_output_dir, int p_threads = -1);
+	Dictionary get_batch_errors() const;
+
+	// Only decompiles the scripts that changed since the run that wrote the manifest, and removes the
+	// output of scripts that are gone. Scripts whose MD5 changed but decode to the same tokens are kept.
+	Error decompile_pack_files_incremental(const String &p_output_dir, const String &p_manifest_path = String(), int p_threads = -1);
+	Dictionary get_change_report() const;
+
+	// Pads the output with blank lines so every statement ends up on its original line
+	void set_preserve_line_numbers(bool p_enable);
+	bool is_preserving_line_numbers() const;
+
+	// Scripts decompiled by the batch functions are looked up in and added to the cache
+	void set_cache(const Ref<GDScriptDecompCache> &p_cache);
+	Ref<GDScriptDecompCache> get_cache() const;
+	// Called while decompile_files() runs, files not started when it returns true fail with "Not decompiled"
+	void set_batch_progress_func(GDScriptBatchProgress::Func p_func, void *p_userdata);
+	String get_decompiler_id() const;
+
+	// Per phase nanoseconds and counters, summed over every script since the last reset, batch runs included
+	Dictionary get_stats() const;
+	void reset_stats();
+
 	String get_script_text();
+	const GDScriptTextBuffer &get_script_buffer() const;
 	String get_error_message();
+	// Message for a script that failed with p_err, for the error lists of batch operations
+	String get_failure_message(Error p_err);
 	String get_constant_string(Vector<Variant> &constants, uint32_t constId);
 	static String get_type_name_v3(int p_type);
 	static String get_type_name_v2(int p_type);
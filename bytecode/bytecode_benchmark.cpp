@@ -0,0 +1,453 @@
+/*************************************************************************/
+/*  bytecode_benchmark.cpp                                               */
+/*************************************************************************/
+
+#include "bytecode_benchmark.h"
+
+#include "bytecode/bytecode_versions.h"
+#include "bytecode/bytecode_writer.h"
+
+#include "core/object/worker_thread_pool.h"
+#include "core/os/memory.h"
+#include "core/os/os.h"
+
+enum {
+	SMALL_FUNCTIONS = 2,
+	TYPICAL_FUNCTIONS = 24,
+	STATEMENTS_PER_FUNCTION = 8,
+	MEMBER_VARIABLES = 12,
+	LARGE_ARRAY_SIZE = 100000,
+	NESTING_DEPTH = 200,
+	MANY_IDENTIFIERS = 20000,
+};
+
+static const GDScriptDecomp::GlobalToken required_tokens[] = {
+	GDScriptDecomp::G_TK_IDENTIFIER,
+	GDScriptDecomp::G_TK_CONSTANT,
+	GDScriptDecomp::G_TK_OP_IN,
+	GDScriptDecomp::G_TK_OP_GREATER,
+	GDScriptDecomp::G_TK_OP_ADD,
+	GDScriptDecomp::G_TK_OP_ASSIGN,
+	GDScriptDecomp::G_TK_OP_ASSIGN_ADD,
+	GDScriptDecomp::G_TK_CF_IF,
+	GDScriptDecomp::G_TK_CF_FOR,
+	GDScriptDecomp::G_TK_CF_RETURN,
+	GDScriptDecomp::G_TK_PR_FUNCTION,
+	GDScriptDecomp::G_TK_PR_EXTENDS,
+	GDScriptDecomp::G_TK_PR_CONST,
+	GDScriptDecomp::G_TK_PR_VAR,
+	GDScriptDecomp::G_TK_BRACKET_OPEN,
+	GDScriptDecomp::G_TK_BRACKET_CLOSE,
+	GDScriptDecomp::G_TK_PARENTHESIS_OPEN,
+	GDScriptDecomp::G_TK_PARENTHESIS_CLOSE,
+	GDScriptDecomp::G_TK_COMMA,
+	GDScriptDecomp::G_TK_PERIOD,
+	GDScriptDecomp::G_TK_COLON,
+	GDScriptDecomp::G_TK_NEWLINE,
+	GDScriptDecomp::G_TK_EOF,
+};
+
+// Writes GDScript shaped token streams, every version supports the tokens used here
+struct BenchmarkScriptGenerator {
+	GDScriptBytecodeWriter writer;
+	int print_func = 0;
+	int range_func = 0;
+
+	void tk(GDScriptDecomp::GlobalToken p_token, uint32_t p_payload = 0) {
+		writer.add_token(p_token, p_payload);
+	}
+	// Godot 4 has no built-in function and type tokens, they are identifiers there
+	void func(int p_func, const char *p_name) {
+		if (p_func >= 0) {
+			tk(GDScriptDecomp::G_TK_BUILT_IN_FUNC, p_func);
+		} else {
+			writer.add_identifier(p_name);
+		}
+	}
+	void vector2() {
+		if (writer.has_token(GDScriptDecomp::G_TK_BUILT_IN_TYPE)) {
+			tk(GDScriptDecomp::G_TK_BUILT_IN_TYPE, 5); // Vector2 in both Variant enums
+		} else {
+			writer.add_identifier("Vector2");
+		}
+	}
+	void newline(int p_indent) {
+		writer.add_token(GDScriptDecomp::G_TK_NEWLINE, p_indent);
+		writer.set_line(writer.get_line() + 1);
+	}
+	String member(uint32_t p_idx) {
+		return "member_" + itos(p_idx);
+	}
+
+	void header(int p_members) {
+		tk(GDScriptDecomp::G_TK_PR_EXTENDS);
+		writer.add_identifier("Node");
+		newline(0);
+		for (int i = 0; i < p_members; i++) {
+			// var member_0 = 0 / 0.5 / "member 0"
+			tk(GDScriptDecomp::G_TK_PR_VAR);
+			writer.add_identifier(member(i));
+			tk(GDScriptDecomp::G_TK_OP_ASSIGN);
+			switch (i % 3) {
+				case 0:
+					writer.add_constant(i);
+					break;
+				case 1:
+					writer.add_constant(i + 0.5);
+					break;
+				default:
+					writer.add_constant("member " + itos(i));
+			}
+			newline(0);
+		}
+	}
+
+	void statement(uint32_t p_seed, int p_indent, int p_members) {
+		String a = member(p_seed % p_members);
+		String b = member((p_seed * 7 + 3) % p_members);
+		switch (p_seed % 5) {
+			case 0: {
+				// var local_0 = member_3 + 0
+				tk(GDScriptDecomp::G_TK_PR_VAR);
+				writer.add_identifier("local_" + itos(p_seed));
+				tk(GDScriptDecomp::G_TK_OP_ASSIGN);
+				writer.add_identifier(b);
+				tk(GDScriptDecomp::G_TK_OP_ADD);
+				writer.add_constant(int(p_seed % 100));
+				newline(p_indent);
+			} break;
+			case 1: {
+				// print(member_1, "text")
+				func(print_func, "print");
+				tk(GDScriptDecomp::G_TK_PARENTHESIS_OPEN);
+				writer.add_identifier(a);
+				tk(GDScriptDecomp::G_TK_COMMA);
+				writer.add_constant("statement " + itos(p_seed));
+				tk(GDScriptDecomp::G_TK_PARENTHESIS_CLOSE);
+				newline(p_indent);
+			} break;
+			case 2: {
+				// if member_2 > 2:
+				//     member_2 += 1
+				tk(GDScriptDecomp::G_TK_CF_IF);
+				writer.add_identifier(a);
+				tk(GDScriptDecomp::G_TK_OP_GREATER);
+				writer.add_constant(int(p_seed % 10));
+				tk(GDScriptDecomp::G_TK_COLON);
+				newline(p_indent + 1);
+				writer.add_identifier(a);
+				tk(GDScriptDecomp::G_TK_OP_ASSIGN_ADD);
+				writer.add_constant(1);
+				newline(p_indent);
+			} break;
+			case 3: {
+				// for i in range(3):
+				//     print(i)
+				tk(GDScriptDecomp::G_TK_CF_FOR);
+				writer.add_identifier("i");
+				tk(GDScriptDecomp::G_TK_OP_IN);
+				func(range_func, "range");
+				tk(GDScriptDecomp::G_TK_PARENTHESIS_OPEN);
+				writer.add_constant(int(p_seed % 10));
+				tk(GDScriptDecomp::G_TK_PARENTHESIS_CLOSE);
+				tk(GDScriptDecomp::G_TK_COLON);
+				newline(p_indent + 1);
+				func(print_func, "print");
+				tk(GDScriptDecomp::G_TK_PARENTHESIS_OPEN);
+				writer.add_identifier("i");
+				tk(GDScriptDecomp::G_TK_PARENTHESIS_CLOSE);
+				newline(p_indent);
+			} break;
+			default: {
+				// member_4.set_position(Vector2(1.5, 4))
+				writer.add_identifier(a);
+				tk(GDScriptDecomp::G_TK_PERIOD);
+				writer.add_identifier("set_position");
+				tk(GDScriptDecomp::G_TK_PARENTHESIS_OPEN);
+				vector2();
+				tk(GDScriptDecomp::G_TK_PARENTHESIS_OPEN);
+				writer.add_constant(1.5);
+				tk(GDScriptDecomp::G_TK_COMMA);
+				writer.add_constant(int(p_seed % 10));
+				tk(GDScriptDecomp::G_TK_PARENTHESIS_CLOSE);
+				tk(GDScriptDecomp::G_TK_PARENTHESIS_CLOSE);
+				newline(p_indent);
+			}
+		}
+	}
+
+	void function(int p_idx, int p_statements, int p_members) {
+		// func function_0(arg):
+		tk(GDScriptDecomp::G_TK_PR_FUNCTION);
+		writer.add_identifier("function_" + itos(p_idx));
+		tk(GDScriptDecomp::G_TK_PARENTHESIS_OPEN);
+		writer.add_identifier("arg");
+		tk(GDScriptDecomp::G_TK_PARENTHESIS_CLOSE);
+		tk(GDScriptDecomp::G_TK_COLON);
+		newline(1);
+		for (int i = 0; i < p_statements; i++) {
+			statement(p_idx * p_statements + i, 1, p_members);
+		}
+		tk(GDScriptDecomp::G_TK_CF_RETURN);
+		writer.add_identifier("arg");
+		newline(0);
+	}
+
+	BenchmarkScriptGenerator(const GDScriptDecomp *p_decomp) :
+			writer(p_decomp) {
+		print_func = writer.find_function("print");
+		range_func = writer.find_function("range");
+	}
+};
+
+PackedStringArray GDScriptDecompBenchmark::get_shapes() {
+	PackedStringArray shapes;
+	shapes.push_back("small");
+	shapes.push_back("typical");
+	shapes.push_back("large_array");
+	shapes.push_back("deep_nesting");
+	shapes.push_back("many_identifiers");
+	return shapes;
+}
+
+Vector<uint8_t> GDScriptDecompBenchmark::generate_script(int64_t p_commit, const String &p_shape) {
+	GDScriptDecomp *decomp = create_decomp_for_commit(p_commit);
+	ERR_FAIL_COND_V_MSG(!decomp, Vector<uint8_t>(), "Unknown bytecode version " + String::num_int64(p_commit, 16) + ".");
+
+	Vector<uint8_t> ret;
+	BenchmarkScriptGenerator gen(decomp);
+	for (uint32_t i = 0; i < sizeof(required_tokens) / sizeof(required_tokens[0]); i++) {
+		if (!gen.writer.has_token(required_tokens[i])) {
+			memdelete(decomp);
+			ERR_FAIL_V_MSG(ret, "Bytecode version " + String::num_int64(p_commit, 16) + " lacks tokens the benchmark needs.");
+		}
+	}
+	if (decomp->get_function_count() > 0 && (gen.print_func < 0 || gen.range_func < 0)) {
+		memdelete(decomp);
+		ERR_FAIL_V(ret);
+	}
+
+	if (p_shape == "small") {
+		gen.header(3);
+		for (int i = 0; i < SMALL_FUNCTIONS; i++) {
+			gen.function(i, STATEMENTS_PER_FUNCTION / 2, 3);
+		}
+	} else if (p_shape == "typical") {
+		gen.header(MEMBER_VARIABLES);
+		for (int i = 0; i < TYPICAL_FUNCTIONS; i++) {
+			gen.function(i, STATEMENTS_PER_FUNCTION, MEMBER_VARIABLES);
+		}
+	} else if (p_shape == "large_array") {
+		// const DATA = [0, 1.5, "item 2", 3, ...], one constant per element and all on one line
+		gen.header(1);
+		gen.tk(GDScriptDecomp::G_TK_PR_CONST);
+		gen.writer.add_identifier("DATA");
+		gen.tk(GDScriptDecomp::G_TK_OP_ASSIGN);
+		gen.tk(GDScriptDecomp::G_TK_BRACKET_OPEN);
+		for (int i = 0; i < LARGE_ARRAY_SIZE; i++) {
+			if (i > 0) {
+				gen.tk(GDScriptDecomp::G_TK_COMMA);
+			}
+			switch (i % 3) {
+				case 0:
+					gen.writer.add_constant(i);
+					break;
+				case 1:
+					gen.writer.add_constant(i + 0.5);
+					break;
+				default:
+					gen.writer.add_constant("item " + itos(i));
+			}
+		}
+		gen.tk(GDScriptDecomp::G_TK_BRACKET_CLOSE);
+		gen.newline(0);
+	} else if (p_shape == "deep_nesting") {
+		gen.header(MEMBER_VARIABLES);
+		gen.tk(GDScriptDecomp::G_TK_PR_FUNCTION);
+		gen.writer.add_identifier("nested");
+		gen.tk(GDScriptDecomp::G_TK_PARENTHESIS_OPEN);
+		gen.tk(GDScriptDecomp::G_TK_PARENTHESIS_CLOSE);
+		gen.tk(GDScriptDecomp::G_TK_COLON);
+		gen.newline(1);
+		for (int i = 0; i < NESTING_DEPTH; i++) {
+			gen.statement(i * 5, i + 1, MEMBER_VARIABLES);
+			// if member_0 > 0:
+			gen.tk(GDScriptDecomp::G_TK_CF_IF);
+			gen.writer.add_identifier(gen.member(i % MEMBER_VARIABLES));
+			gen.tk(GDScriptDecomp::G_TK_OP_GREATER);
+			gen.writer.add_constant(i);
+			gen.tk(GDScriptDecomp::G_TK_COLON);
+			gen.newline(i + 2);
+		}
+		gen.tk(GDScriptDecomp::G_TK_CF_RETURN);
+		gen.writer.add_identifier(gen.member(0));
+		gen.newline(0);
+	} else if (p_shape == "many_identifiers") {
+		gen.header(MANY_IDENTIFIERS);
+		gen.function(0, STATEMENTS_PER_FUNCTION, MANY_IDENTIFIERS);
+	} else {
+		memdelete(decomp);
+		ERR_FAIL_V_MSG(ret, "Unknown benchmark shape '" + p_shape + "'.");
+	}
+	gen.tk(GDScriptDecomp::G_TK_EOF);
+	ret = gen.writer.get_bytecode();
+	memdelete(decomp);
+	return ret;
+}
+
+Dictionary GDScriptDecompBenchmark::_measure_script(GDScriptDecomp *p_decomp, const Vector<uint8_t> &p_script, int p_iterations) {
+	Dictionary d;
+	d["bytes"] = p_script.size();
+
+	// Allocations are counted by the decompiler itself, so they're known in release builds too
+	p_decomp->reset_stats();
+	uint64_t begin = OS::get_singleton()->get_ticks_usec();
+	Error err = p_decomp->decompile_span(p_script.ptr(), p_script.size());
+	uint64_t first_usec = MAX(OS::get_singleton()->get_ticks_usec() - begin, (uint64_t)1);
+	d["first_allocations"] = p_decomp->get_stats()["allocations"];
+	if (err != OK) {
+		d["error"] = p_decomp->get_failure_message(err);
+		return d;
+	}
+	d["output_bytes"] = p_decomp->get_script_buffer().get_total_size();
+	d["first_usec"] = first_usec;
+
+	// Small scripts are run in batches so each sample is long enough to time
+	int reps = CLAMP(MIN_SAMPLE_USEC / first_usec, (uint64_t)1, (uint64_t)100000);
+	Vector<double> samples;
+	p_decomp->reset_stats();
+	for (int i = 0; i < p_iterations; i++) {
+		begin = OS::get_singleton()->get_ticks_usec();
+		for (int j = 0; j < reps; j++) {
+			p_decomp->decompile_span(p_script.ptr(), p_script.size());
+		}
+		samples.push_back(double(OS::get_singleton()->get_ticks_usec() - begin) / reps);
+	}
+	samples.sort();
+	double usec = MAX(samples[samples.size() / 2], 0.001);
+	d["usec_per_script"] = usec;
+	d["scripts_per_sec"] = 1000000.0 / usec;
+	d["mb_per_sec"] = p_script.size() / usec; // bytes per usec
+	// Once the scratch buffers fit the script, this should stay at 0
+	d["allocations_per_script"] = double(int64_t(p_decomp->get_stats()["allocations"])) / (reps * p_iterations);
+	return d;
+}
+
+void GDScriptDecompBenchmark::_thread_worker(uint32_t p_worker, ThreadData *p_data) {
+	GDScriptDecomp *decomp = create_decomp_for_commit(p_data->commit);
+	ERR_FAIL_COND(!decomp);
+	while (p_data->next_job.postincrement() < THREAD_JOBS) {
+		if (decomp->decompile_span(p_data->script.ptr(), p_data->script.size()) != OK) {
+			p_data->failed_jobs.increment();
+		}
+	}
+	memdelete(decomp);
+}
+
+Array GDScriptDecompBenchmark::_measure_threads(uint64_t p_commit, int p_max_threads) {
+	Array ret;
+	ThreadData data;
+	data.commit = p_commit;
+	data.script = generate_script(p_commit, "typical");
+	ERR_FAIL_COND_V(data.script.is_empty(), ret);
+
+	double single_usec = 0;
+	for (int threads = 1; threads <= p_max_threads; threads = threads < p_max_threads ? MIN(threads * 2, p_max_threads) : threads + 1) {
+		data.next_job.set(0);
+		data.failed_jobs.set(0);
+		uint64_t begin = OS::get_singleton()->get_ticks_usec();
+		WorkerThreadPool::GroupID group_id = WorkerThreadPool::get_singleton()->add_template_group_task(this, &GDScriptDecompBenchmark::_thread_worker, &data, threads, threads, true, "GDScriptDecompBenchmark::run");
+		WorkerThreadPool::get_singleton()->wait_for_group_task_completion(group_id);
+		double usec = MAX(double(OS::get_singleton()->get_ticks_usec() - begin), 1.0);
+		if (threads == 1) {
+			single_usec = usec;
+		}
+
+		Dictionary d;
+		d["threads"] = threads;
+		d["scripts"] = THREAD_JOBS;
+		d["failed"] = data.failed_jobs.get();
+		d["scripts_per_sec"] = THREAD_JOBS * 1000000.0 / usec;
+		d["mb_per_sec"] = double(THREAD_JOBS) * data.script.size() / usec;
+		d["speedup"] = single_usec / usec;
+		ret.push_back(d);
+	}
+	return ret;
+}
+
+Dictionary GDScriptDecompBenchmark::run(int p_iterations, int p_max_threads, int64_t p_commit) {
+	ERR_FAIL_COND_V(p_iterations <= 0, Dictionary());
+	int max_threads = p_max_threads > 0 ? p_max_threads : WorkerThreadPool::get_singleton()->get_thread_count();
+	PackedStringArray shapes = get_shapes();
+
+	Dictionary totals; // shape -> { bytes, usec }
+	Array versions;
+	uint64_t thread_commit = 0;
+	for (int i = 0; decomp_versions[i].commit != 0; i++) {
+		uint64_t commit = decomp_versions[i].commit;
+		if (p_commit != 0 && (uint64_t)p_commit != commit) {
+			continue;
+		}
+		GDScriptDecomp *decomp = create_decomp_for_commit(commit);
+		if (!decomp) {
+			continue;
+		}
+		if (thread_commit == 0) {
+			thread_commit = commit;
+		}
+
+		Dictionary version;
+		version["commit"] = String::num_int64(commit, 16).lpad(7, "0");
+		version["name"] = decomp_versions[i].name.strip_edges();
+		version["bytecode_version"] = decomp->get_bytecode_version();
+		version["decompiler_id"] = decomp->get_decompiler_id();
+		Dictionary results;
+		for (int j = 0; j < shapes.size(); j++) {
+			Vector<uint8_t> script = generate_script(commit, shapes[j]);
+			if (script.is_empty()) {
+				continue;
+			}
+			Dictionary r = _measure_script(decomp, script, p_iterations);
+			results[shapes[j]] = r;
+			if (r.has("usec_per_script")) {
+				Dictionary t = totals.has(shapes[j]) ? Dictionary(totals[shapes[j]]) : Dictionary();
+				t["bytes"] = double(t.get("bytes", 0.0)) + script.size();
+				t["usec"] = double(t.get("usec", 0.0)) + double(r["usec_per_script"]);
+				t["scripts"] = int(t.get("scripts", 0)) + 1;
+				totals[shapes[j]] = t;
+			}
+		}
+		version["shapes"] = results;
+		versions.push_back(version);
+		memdelete(decomp);
+	}
+	ERR_FAIL_COND_V_MSG(versions.is_empty(), Dictionary(), "Unknown bytecode version " + String::num_int64(p_commit, 16) + ".");
+
+	Dictionary summary;
+	for (int i = 0; i < shapes.size(); i++) {
+		if (!totals.has(shapes[i])) {
+			continue;
+		}
+		Dictionary t = totals[shapes[i]];
+		double usec = MAX(double(t["usec"]), 0.001);
+		Dictionary s;
+		s["scripts_per_sec"] = int(t["scripts"]) * 1000000.0 / usec;
+		s["mb_per_sec"] = double(t["bytes"]) / usec;
+		summary[shapes[i]] = s;
+	}
+
+	Dictionary ret;
+	ret["iterations"] = p_iterations;
+	ret["processor_count"] = OS::get_singleton()->get_processor_count();
+	ret["versions"] = versions;
+	ret["summary"] = summary;
+	ret["thread_commit"] = String::num_int64(thread_commit, 16).lpad(7, "0");
+	ret["threads"] = _measure_threads(thread_commit, max_threads);
+	return ret;
+}
+
+void GDScriptDecompBenchmark::_bind_methods() {
+	ClassDB::bind_static_method("GDScriptDecompBenchmark", D_METHOD("get_shapes"), &GDScriptDecompBenchmark::get_shapes);
+	ClassDB::bind_static_method("GDScriptDecompBenchmark", D_METHOD("generate_script", "commit", "shape"), &GDScriptDecompBenchmark::generate_script);
+	ClassDB::bind_method(D_METHOD("run", "iterations", "max_threads", "commit"), &GDScriptDecompBenchmark::run, DEFVAL(5), DEFVAL(-1), DEFVAL(0));
+}
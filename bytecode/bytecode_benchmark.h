@@ -0,0 +1,43 @@
+/*************************************************************************/
+/*  bytecode_benchmark.h                                                 */
+/*************************************************************************/
+
+#ifndef GDSCRIPT_DECOMP_BENCHMARK_H
+#define GDSCRIPT_DECOMP_BENCHMARK_H
+
+#include "bytecode_base.h"
+#include "core/object/ref_counted.h"
+
+// Decompiler throughput on a synthetic corpus, generated for every supported bytecode version.
+// Results are returned as a Dictionary so they can be saved as JSON and compared between builds.
+class GDScriptDecompBenchmark : public RefCounted {
+	GDCLASS(GDScriptDecompBenchmark, RefCounted);
+
+	enum {
+		MIN_SAMPLE_USEC = 20000,
+		THREAD_JOBS = 1024,
+	};
+
+	struct ThreadData {
+		uint64_t commit = 0;
+		Vector<uint8_t> script;
+		SafeNumeric<uint32_t> next_job;
+		SafeNumeric<uint32_t> failed_jobs;
+	};
+	void _thread_worker(uint32_t p_worker, ThreadData *p_data);
+
+	Dictionary _measure_script(GDScriptDecomp *p_decomp, const Vector<uint8_t> &p_script, int p_iterations);
+	Array _measure_threads(uint64_t p_commit, int p_max_threads);
+
+protected:
+	static void _bind_methods();
+
+public:
+	static PackedStringArray get_shapes();
+	static Vector<uint8_t> generate_script(int64_t p_commit, const String &p_shape);
+
+	// Runs every shape through every version (or only p_commit), then the typical shape on 1..p_max_threads threads
+	Dictionary run(int p_iterations = 5, int p_max_threads = -1, int64_t p_commit = 0);
+};
+
+#endif
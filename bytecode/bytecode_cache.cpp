@@ -0,0 +1,327 @@
+/*************************************************************************/
+/*  bytecode_cache.cpp                                                   */
+/*************************************************************************/
+
+#include "bytecode_cache.h"
+
+#include "core/io/dir_access.h"
+#include "core/io/file_access.h"
+#include "core/os/thread.h"
+
+String GDScriptDecompCache::_get_entry_path(const String &p_key) const {
+	return cache_dir.plus_file(p_key + ".gd");
+}
+
+String GDScriptDecompCache::_get_index_path() const {
+	return cache_dir.plus_file("cache_index");
+}
+
+Error GDScriptDecompCache::_load_index() {
+	Ref<FileAccess> f = FileAccess::open(_get_index_path(), FileAccess::READ);
+	if (f.is_null()) {
+		return ERR_FILE_NOT_FOUND;
+	}
+	uint8_t magic[4];
+	f->get_buffer(magic, 4);
+	uint32_t version = f->get_32();
+	ERR_FAIL_COND_V(magic[0] != 'G' || magic[1] != 'D' || magic[2] != 'D' || magic[3] != 'C' || version != FORMAT_VERSION, ERR_FILE_UNRECOGNIZED);
+
+	access_counter = f->get_64();
+	uint32_t count = f->get_32();
+	for (uint32_t i = 0; i < count; i++) {
+		String key = f->get_pascal_string();
+		Entry e;
+		e.size = f->get_64();
+		e.last_access = f->get_64();
+		ERR_FAIL_COND_V(f->eof_reached(), ERR_FILE_CORRUPT);
+		entries[key] = e;
+		total_size += e.size;
+	}
+	return OK;
+}
+
+void GDScriptDecompCache::_reconcile_index() {
+	// The index is only written by close(), after a crash it's missing or out of date. Entries follow what's
+	// actually on disk, unknown files are kept as least recently used, leftovers of interrupted stores are removed.
+	HashMap<String, Entry> found;
+	uint64_t found_size = 0;
+	Vector<String> stale_files;
+	Ref<DirAccess> da = DirAccess::open(cache_dir);
+	ERR_FAIL_COND(da.is_null());
+	da->list_dir_begin();
+	for (String f = da->get_next(); !f.is_empty(); f = da->get_next()) {
+		if (da->current_is_dir()) {
+			continue;
+		}
+		if (f.get_extension().begins_with("tmp") && f.get_basename().get_extension() == "gd") {
+			stale_files.push_back(f);
+			continue;
+		}
+		if (f.get_extension() != "gd") {
+			continue;
+		}
+		Ref<FileAccess> fa = FileAccess::open(cache_dir.plus_file(f), FileAccess::READ);
+		if (fa.is_null()) {
+			continue;
+		}
+		String key = f.get_basename();
+		const Entry *known = entries.getptr(key);
+		Entry e;
+		e.size = fa->get_length();
+		if (known) {
+			e.last_access = known->last_access;
+		}
+		if (!known || known->size != e.size) {
+			dirty = true;
+		}
+		found[key] = e;
+		found_size += e.size;
+	}
+	da->list_dir_end();
+
+	for (int i = 0; i < stale_files.size(); i++) {
+		da->remove(cache_dir.plus_file(stale_files[i]));
+	}
+	if (found.size() != entries.size()) {
+		dirty = true;
+	}
+	entries = found;
+	total_size = found_size;
+}
+
+void GDScriptDecompCache::_evict() {
+	struct EvictSort {
+		uint64_t last_access;
+		String key;
+		bool operator<(const EvictSort &p_other) const { return last_access < p_other.last_access; }
+	};
+
+	// Go down to 90% of the limit so a full cache doesn't evict on every store
+	uint64_t target_size = max_size - max_size / 10;
+	Vector<EvictSort> order;
+	for (const KeyValue<String, Entry> &E : entries) {
+		order.push_back({ E.value.last_access, E.key });
+	}
+	order.sort();
+
+	Ref<DirAccess> da = DirAccess::create(DirAccess::ACCESS_FILESYSTEM);
+	for (int i = 0; i < order.size() && total_size > target_size; i++) {
+		da->remove(_get_entry_path(order[i].key));
+		total_size -= entries[order[i].key].size;
+		entries.erase(order[i].key);
+	}
+	dirty = true;
+}
+
+Error GDScriptDecompCache::open(const String &p_dir, uint64_t p_max_size) {
+	close();
+	MutexLock lock(mutex);
+
+	Ref<DirAccess> da = DirAccess::create(DirAccess::ACCESS_FILESYSTEM);
+	Error err = da->make_dir_recursive(p_dir);
+	ERR_FAIL_COND_V_MSG(err != OK && err != ERR_ALREADY_EXISTS, err, "Can't create cache directory '" + p_dir + "'.");
+
+	cache_dir = p_dir;
+	max_size = p_max_size;
+	total_size = 0;
+	access_counter = 0;
+	hits = 0;
+	misses = 0;
+	dirty = false;
+	entries.clear();
+	_load_index();
+	_reconcile_index();
+	if (total_size > max_size) {
+		_evict();
+	}
+	return OK;
+}
+
+Error GDScriptDecompCache::close() {
+	MutexLock lock(mutex);
+	if (cache_dir.is_empty()) {
+		return OK;
+	}
+	if (dirty) {
+		Ref<FileAccess> f = FileAccess::open(_get_index_path(), FileAccess::WRITE);
+		ERR_FAIL_COND_V_MSG(f.is_null(), ERR_FILE_CANT_WRITE, "Can't write cache index in '" + cache_dir + "'.");
+		f->store_buffer((const uint8_t *)"GDDC", 4);
+		f->store_32(FORMAT_VERSION);
+		f->store_64(access_counter);
+		f->store_32(entries.size());
+		for (const KeyValue<String, Entry> &E : entries) {
+			f->store_pascal_string(E.key);
+			f->store_64(E.value.size);
+			f->store_64(E.value.last_access);
+		}
+	}
+	cache_dir = String();
+	entries.clear();
+	dirty = false;
+	return OK;
+}
+
+bool GDScriptDecompCache::is_open() const {
+	MutexLock lock(mutex);
+	return !cache_dir.is_empty();
+}
+
+Error GDScriptDecompCache::clear() {
+	MutexLock lock(mutex);
+	ERR_FAIL_COND_V(cache_dir.is_empty(), ERR_UNCONFIGURED);
+	Ref<DirAccess> da = DirAccess::create(DirAccess::ACCESS_FILESYSTEM);
+	for (const KeyValue<String, Entry> &E : entries) {
+		da->remove(_get_entry_path(E.key));
+	}
+	entries.clear();
+	total_size = 0;
+	dirty = true;
+	return OK;
+}
+
+String GDScriptDecompCache::make_key(const String &p_md5, const String &p_decompiler_id) {
+	return p_md5.to_lower() + "_" + p_decompiler_id.md5_text().substr(0, 8);
+}
+
+Error GDScriptDecompCache::fetch(const String &p_key, const String &p_target_path) {
+	String path;
+	{
+		MutexLock lock(mutex);
+		ERR_FAIL_COND_V(cache_dir.is_empty(), ERR_UNCONFIGURED);
+		if (!entries.has(p_key)) {
+			misses++;
+			return ERR_DOES_NOT_EXIST;
+		}
+		path = _get_entry_path(p_key);
+	}
+
+	// Copy in chunks, scripts can be large
+	Ref<DirAccess> da = DirAccess::create(DirAccess::ACCESS_FILESYSTEM);
+	Error err = da->copy(path, p_target_path);
+
+	MutexLock lock(mutex);
+	Entry *e = entries.getptr(p_key);
+	if (err != OK || !e) {
+		// Removed or evicted behind our back
+		if (e) {
+			total_size -= e->size;
+			entries.erase(p_key);
+			dirty = true;
+		}
+		misses++;
+		return ERR_DOES_NOT_EXIST;
+	}
+	e->last_access = ++access_counter;
+	hits++;
+	dirty = true;
+	return OK;
+}
+
+Error GDScriptDecompCache::_commit_entry(const String &p_key, const String &p_tmp_path, uint64_t p_len) {
+	MutexLock lock(mutex);
+	Ref<DirAccess> da = DirAccess::create(DirAccess::ACCESS_FILESYSTEM);
+	if (cache_dir.is_empty() || da->rename(p_tmp_path, _get_entry_path(p_key)) != OK) {
+		da->remove(p_tmp_path);
+		return ERR_FILE_CANT_WRITE;
+	}
+	Entry *e = entries.getptr(p_key);
+	if (e) {
+		total_size -= e->size;
+	} else {
+		e = &entries.insert(p_key, Entry())->value;
+	}
+	e->size = p_len;
+	e->last_access = ++access_counter;
+	total_size += p_len;
+	dirty = true;
+	if (total_size > max_size) {
+		_evict();
+	}
+	return OK;
+}
+
+Error GDScriptDecompCache::store(const String &p_key, const uint8_t *p_data, uint64_t p_len) {
+	String path;
+	{
+		MutexLock lock(mutex);
+		ERR_FAIL_COND_V(cache_dir.is_empty(), ERR_UNCONFIGURED);
+		path = _get_entry_path(p_key);
+	}
+
+	// Write to a temporary name, so other workers never see half a file
+	String tmp_path = path + ".tmp" + itos(Thread::get_caller_id());
+	{
+		Ref<FileAccess> f = FileAccess::open(tmp_path, FileAccess::WRITE);
+		ERR_FAIL_COND_V(f.is_null(), ERR_FILE_CANT_WRITE);
+		f->store_buffer(p_data, p_len);
+	}
+	return _commit_entry(p_key, tmp_path, p_len);
+}
+
+Error GDScriptDecompCache::store_file(const String &p_key, const String &p_source_path) {
+	String path;
+	{
+		MutexLock lock(mutex);
+		ERR_FAIL_COND_V(cache_dir.is_empty(), ERR_UNCONFIGURED);
+		path = _get_entry_path(p_key);
+	}
+
+	String tmp_path = path + ".tmp" + itos(Thread::get_caller_id());
+	Ref<DirAccess> da = DirAccess::create(DirAccess::ACCESS_FILESYSTEM);
+	Error err = da->copy(p_source_path, tmp_path);
+	ERR_FAIL_COND_V(err != OK, err);
+	Ref<FileAccess> f = FileAccess::open(tmp_path, FileAccess::READ);
+	ERR_FAIL_COND_V(f.is_null(), ERR_FILE_CANT_READ);
+	uint64_t len = f->get_length();
+	f = Ref<FileAccess>();
+	return _commit_entry(p_key, tmp_path, len);
+}
+
+void GDScriptDecompCache::set_max_size(uint64_t p_max_size) {
+	MutexLock lock(mutex);
+	max_size = p_max_size;
+	if (!cache_dir.is_empty() && total_size > max_size) {
+		_evict();
+	}
+}
+
+uint64_t GDScriptDecompCache::get_max_size() const {
+	return max_size;
+}
+
+uint64_t GDScriptDecompCache::get_size() const {
+	MutexLock lock(mutex);
+	return total_size;
+}
+
+int GDScriptDecompCache::get_entry_count() const {
+	MutexLock lock(mutex);
+	return entries.size();
+}
+
+uint64_t GDScriptDecompCache::get_hit_count() const {
+	MutexLock lock(mutex);
+	return hits;
+}
+
+uint64_t GDScriptDecompCache::get_miss_count() const {
+	MutexLock lock(mutex);
+	return misses;
+}
+
+void GDScriptDecompCache::_bind_methods() {
+	ClassDB::bind_method(D_METHOD("open", "dir", "max_size"), &GDScriptDecompCache::open, DEFVAL(256 * 1024 * 1024));
+	ClassDB::bind_method(D_METHOD("close"), &GDScriptDecompCache::close);
+	ClassDB::bind_method(D_METHOD("is_open"), &GDScriptDecompCache::is_open);
+	ClassDB::bind_method(D_METHOD("clear"), &GDScriptDecompCache::clear);
+	ClassDB::bind_method(D_METHOD("set_max_size", "max_size"), &GDScriptDecompCache::set_max_size);
+	ClassDB::bind_method(D_METHOD("get_max_size"), &GDScriptDecompCache::get_max_size);
+	ClassDB::bind_method(D_METHOD("get_size"), &GDScriptDecompCache::get_size);
+	ClassDB::bind_method(D_METHOD("get_entry_count"), &GDScriptDecompCache::get_entry_count);
+	ClassDB::bind_method(D_METHOD("get_hit_count"), &GDScriptDecompCache::get_hit_count);
+	ClassDB::bind_method(D_METHOD("get_miss_count"), &GDScriptDecompCache::get_miss_count);
+}
+
+GDScriptDecompCache::~GDScriptDecompCache() {
+	close();
+}
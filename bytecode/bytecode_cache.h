@@ -0,0 +1,68 @@
+/*************************************************************************/
+/*  bytecode_cache.h                                                     */
+/*************************************************************************/
+
+#ifndef GDSCRIPT_DECOMP_CACHE_H
+#define GDSCRIPT_DECOMP_CACHE_H
+
+#include "core/object/class_db.h"
+#include "core/object/ref_counted.h"
+#include "core/os/mutex.h"
+#include "core/templates/hash_map.h"
+
+// On-disk cache of decompiled scripts, keyed by the MD5 of the bytecode and the decompiler that produced them.
+// Least recently used entries are evicted once the cache grows past its size limit.
+class GDScriptDecompCache : public RefCounted {
+	GDCLASS(GDScriptDecompCache, RefCounted);
+
+	enum {
+		FORMAT_VERSION = 1,
+	};
+
+	struct Entry {
+		uint64_t size = 0;
+		uint64_t last_access = 0;
+	};
+
+	Mutex mutex;
+	String cache_dir;
+	HashMap<String, Entry> entries;
+	uint64_t max_size = 256 * 1024 * 1024;
+	uint64_t total_size = 0;
+	uint64_t access_counter = 0;
+	uint64_t hits = 0;
+	uint64_t misses = 0;
+	bool dirty = false;
+
+	String _get_entry_path(const String &p_key) const;
+	String _get_index_path() const;
+	Error _commit_entry(const String &p_key, const String &p_tmp_path, uint64_t p_len);
+	Error _load_index();
+	void _reconcile_index();
+	void _evict();
+
+protected:
+	static void _bind_methods();
+
+public:
+	Error open(const String &p_dir, uint64_t p_max_size = 256 * 1024 * 1024);
+	Error close();
+	bool is_open() const;
+	Error clear();
+
+	static String make_key(const String &p_md5, const String &p_decompiler_id);
+	Error fetch(const String &p_key, const String &p_target_path);
+	Error store(const String &p_key, const uint8_t *p_data, uint64_t p_len);
+	Error store_file(const String &p_key, const String &p_source_path);
+
+	void set_max_size(uint64_t p_max_size);
+	uint64_t get_max_size() const;
+	uint64_t get_size() const;
+	int get_entry_count() const;
+	uint64_t get_hit_count() const;
+	uint64_t get_miss_count() const;
+
+	~GDScriptDecompCache();
+};
+
+#endif
@@ -0,0 +1,814 @@
+/*************************************************************************/
+/*  bytecode_compiler.cpp                                                */
+/*************************************************************************/
+
+#include "bytecode_compiler.h"
+
+#include "core/io/dir_access.h"
+#include "core/io/file_access.h"
+#include "core/io/marshalls.h"
+#include "core/object/worker_thread_pool.h"
+#include "core/templates/rb_set.h"
+
+struct CompilerKeyword {
+	const char *text;
+	GDScriptDecomp::GlobalToken token;
+};
+
+// Same spelling the decompiler emits, versions without the token read the word as an identifier
+static const CompilerKeyword compiler_keywords[] = {
+	{ "self", GDScriptDecomp::G_TK_SELF },
+	{ "in", GDScriptDecomp::G_TK_OP_IN },
+	{ "and", GDScriptDecomp::G_TK_OP_AND },
+	{ "or", GDScriptDecomp::G_TK_OP_OR },
+	{ "not", GDScriptDecomp::G_TK_OP_NOT },
+	{ "if", GDScriptDecomp::G_TK_CF_IF },
+	{ "elif", GDScriptDecomp::G_TK_CF_ELIF },
+	{ "else", GDScriptDecomp::G_TK_CF_ELSE },
+	{ "for", GDScriptDecomp::G_TK_CF_FOR },
+	{ "do", GDScriptDecomp::G_TK_CF_DO },
+	{ "while", GDScriptDecomp::G_TK_CF_WHILE },
+	{ "switch", GDScriptDecomp::G_TK_CF_SWITCH },
+	{ "case", GDScriptDecomp::G_TK_CF_CASE },
+	{ "break", GDScriptDecomp::G_TK_CF_BREAK },
+	{ "continue", GDScriptDecomp::G_TK_CF_CONTINUE },
+	{ "pass", GDScriptDecomp::G_TK_CF_PASS },
+	{ "return", GDScriptDecomp::G_TK_CF_RETURN },
+	{ "match", GDScriptDecomp::G_TK_CF_MATCH },
+	{ "func", GDScriptDecomp::G_TK_PR_FUNCTION },
+	{ "class", GDScriptDecomp::G_TK_PR_CLASS },
+	{ "class_name", GDScriptDecomp::G_TK_PR_CLASS_NAME },
+	{ "extends", GDScriptDecomp::G_TK_PR_EXTENDS },
+	{ "is", GDScriptDecomp::G_TK_PR_IS },
+	{ "onready", GDScriptDecomp::G_TK_PR_ONREADY },
+	{ "tool", GDScriptDecomp::G_TK_PR_TOOL },
+	{ "static", GDScriptDecomp::G_TK_PR_STATIC },
+	{ "export", GDScriptDecomp::G_TK_PR_EXPORT },
+	{ "setget", GDScriptDecomp::G_TK_PR_SETGET },
+	{ "const", GDScriptDecomp::G_TK_PR_CONST },
+	{ "var", GDScriptDecomp::G_TK_PR_VAR },
+	{ "as", GDScriptDecomp::G_TK_PR_AS },
+	{ "void", GDScriptDecomp::G_TK_PR_VOID },
+	{ "enum", GDScriptDecomp::G_TK_PR_ENUM },
+	{ "preload", GDScriptDecomp::G_TK_PR_PRELOAD },
+	{ "assert", GDScriptDecomp::G_TK_PR_ASSERT },
+	{ "yield", GDScriptDecomp::G_TK_PR_YIELD },
+	{ "signal", GDScriptDecomp::G_TK_PR_SIGNAL },
+	{ "breakpoint", GDScriptDecomp::G_TK_PR_BREAKPOINT },
+	{ "remote", GDScriptDecomp::G_TK_PR_REMOTE },
+	{ "sync", GDScriptDecomp::G_TK_PR_SYNC },
+	{ "master", GDScriptDecomp::G_TK_PR_MASTER },
+	{ "slave", GDScriptDecomp::G_TK_PR_SLAVE },
+	{ "puppet", GDScriptDecomp::G_TK_PR_PUPPET },
+	{ "remotesync", GDScriptDecomp::G_TK_PR_REMOTESYNC },
+	{ "mastersync", GDScriptDecomp::G_TK_PR_MASTERSYNC },
+	{ "slavesync", GDScriptDecomp::G_TK_PR_SLAVESYNC },
+	{ "puppetsync", GDScriptDecomp::G_TK_PR_PUPPETSYNC },
+	{ "PI", GDScriptDecomp::G_TK_CONST_PI },
+	{ "TAU", GDScriptDecomp::G_TK_CONST_TAU },
+	{ "_", GDScriptDecomp::G_TK_WILDCARD },
+	{ "INF", GDScriptDecomp::G_TK_CONST_INF },
+	{ "NAN", GDScriptDecomp::G_TK_CONST_NAN },
+	{ "when", GDScriptDecomp::G_TK_CF_WHEN },
+	{ "await", GDScriptDecomp::G_TK_PR_AWAIT },
+	{ "namespace", GDScriptDecomp::G_TK_PR_NAMESPACE },
+	{ "super", GDScriptDecomp::G_TK_PR_SUPER },
+	{ "trait", GDScriptDecomp::G_TK_PR_TRAIT },
+};
+
+// Longest first, operators the version doesn't know fall through to the shorter ones
+static const CompilerKeyword compiler_operators[] = {
+	{ "**=", GDScriptDecomp::G_TK_OP_ASSIGN_POW },
+	{ "<<=", GDScriptDecomp::G_TK_OP_ASSIGN_SHIFT_LEFT },
+	{ ">>=", GDScriptDecomp::G_TK_OP_ASSIGN_SHIFT_RIGHT },
+	{ "**", GDScriptDecomp::G_TK_OP_POW },
+	{ "->", GDScriptDecomp::G_TK_FORWARD_ARROW },
+	{ "..", GDScriptDecomp::G_TK_PERIOD_PERIOD },
+	{ "<=", GDScriptDecomp::G_TK_OP_LESS_EQUAL },
+	{ ">=", GDScriptDecomp::G_TK_OP_GREATER_EQUAL },
+	{ "==", GDScriptDecomp::G_TK_OP_EQUAL },
+	{ "!=", GDScriptDecomp::G_TK_OP_NOT_EQUAL },
+	{ "&&", GDScriptDecomp::G_TK_OP_AND },
+	{ "||", GDScriptDecomp::G_TK_OP_OR },
+	{ "<<", GDScriptDecomp::G_TK_OP_SHIFT_LEFT },
+	{ ">>", GDScriptDecomp::G_TK_OP_SHIFT_RIGHT },
+	{ "+=", GDScriptDecomp::G_TK_OP_ASSIGN_ADD },
+	{ "-=", GDScriptDecomp::G_TK_OP_ASSIGN_SUB },
+	{ "*=", GDScriptDecomp::G_TK_OP_ASSIGN_MUL },
+	{ "/=", GDScriptDecomp::G_TK_OP_ASSIGN_DIV },
+	{ "%=", GDScriptDecomp::G_TK_OP_ASSIGN_MOD },
+	{ "&=", GDScriptDecomp::G_TK_OP_ASSIGN_BIT_AND },
+	{ "|=", GDScriptDecomp::G_TK_OP_ASSIGN_BIT_OR },
+	{ "^=", GDScriptDecomp::G_TK_OP_ASSIGN_BIT_XOR },
+	{ "<", GDScriptDecomp::G_TK_OP_LESS },
+	{ ">", GDScriptDecomp::G_TK_OP_GREATER },
+	{ "!", GDScriptDecomp::G_TK_OP_NOT },
+	{ "&", GDScriptDecomp::G_TK_OP_BIT_AND },
+	{ "|", GDScriptDecomp::G_TK_OP_BIT_OR },
+	{ "^", GDScriptDecomp::G_TK_OP_BIT_XOR },
+	{ "~", GDScriptDecomp::G_TK_OP_BIT_INVERT },
+	{ "+", GDScriptDecomp::G_TK_OP_ADD },
+	{ "-", GDScriptDecomp::G_TK_OP_SUB },
+	{ "*", GDScriptDecomp::G_TK_OP_MUL },
+	{ "/", GDScriptDecomp::G_TK_OP_DIV },
+	{ "%", GDScriptDecomp::G_TK_OP_MOD },
+	{ "=", GDScriptDecomp::G_TK_OP_ASSIGN },
+	{ "[", GDScriptDecomp::G_TK_BRACKET_OPEN },
+	{ "]", GDScriptDecomp::G_TK_BRACKET_CLOSE },
+	{ "{", GDScriptDecomp::G_TK_CURLY_BRACKET_OPEN },
+	{ "}", GDScriptDecomp::G_TK_CURLY_BRACKET_CLOSE },
+	{ "(", GDScriptDecomp::G_TK_PARENTHESIS_OPEN },
+	{ ")", GDScriptDecomp::G_TK_PARENTHESIS_CLOSE },
+	{ ",", GDScriptDecomp::G_TK_COMMA },
+	{ ";", GDScriptDecomp::G_TK_SEMICOLON },
+	{ ".", GDScriptDecomp::G_TK_PERIOD },
+	{ ":", GDScriptDecomp::G_TK_COLON },
+	{ "$", GDScriptDecomp::G_TK_DOLLAR },
+	{ "?", GDScriptDecomp::G_TK_QUESTION_MARK },
+};
+
+static bool _is_identifier_start(char32_t c) {
+	return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c > 127;
+}
+
+static bool _is_identifier_char(char32_t c) {
+	return _is_identifier_start(c) || (c >= '0' && c <= '9');
+}
+
+static bool _is_digit(char32_t c) {
+	return c >= '0' && c <= '9';
+}
+
+static int _hex_digit(char32_t c) {
+	if (c >= '0' && c <= '9') {
+		return c - '0';
+	}
+	if (c >= 'a' && c <= 'f') {
+		return c - 'a' + 10;
+	}
+	if (c >= 'A' && c <= 'F') {
+		return c - 'A' + 10;
+	}
+	return -1;
+}
+
+Error GDScriptEncryptContext::set_key(const Vector<uint8_t> &p_key) {
+	key_set = false;
+	ERR_FAIL_COND_V(p_key.size() != 32, ERR_INVALID_PARAMETER);
+	Error err = aes.set_encode_key(p_key.ptr(), 256);
+	ERR_FAIL_COND_V(err != OK, err);
+	key_set = true;
+	return OK;
+}
+
+Error GDScriptEncryptContext::encrypt_buffer(const uint8_t *p_data, uint64_t p_len, const uint8_t p_iv[16], LocalVector<uint8_t> &r_buffer) const {
+	ERR_FAIL_COND_V(!key_set, ERR_UNCONFIGURED);
+	uint64_t padded_length = p_len % 16 ? p_len + 16 - (p_len % 16) : p_len;
+	ERR_FAIL_COND_V(padded_length > UINT32_MAX, ERR_OUT_OF_MEMORY);
+
+	// Header and data end up in one buffer, so the file is written with a single store
+	r_buffer.resize(HEADER_SIZE + padded_length);
+	uint8_t *w = r_buffer.ptr();
+	encode_uint32(HEADER_MAGIC, w);
+	ERR_FAIL_COND_V(CryptoCore::md5(p_data, p_len, &w[4]) != OK, ERR_BUG);
+	encode_uint64(p_len, &w[20]);
+	memcpy(&w[28], p_iv, 16);
+	memcpy(&w[HEADER_SIZE], p_data, p_len);
+	memset(&w[HEADER_SIZE + p_len], 0, padded_length - p_len);
+
+	uint8_t iv[16];
+	memcpy(iv, p_iv, 16);
+	ERR_FAIL_COND_V(aes.encrypt_cfb(padded_length, iv, &w[HEADER_SIZE], &w[HEADER_SIZE]) != OK, ERR_BUG);
+	return OK;
+}
+
+void GDScriptBytecodeCompiler::_bind_methods() {
+	ClassDB::bind_method(D_METHOD("set_version", "commit_or_version"), &GDScriptBytecodeCompiler::set_version);
+	ClassDB::bind_method(D_METHOD("get_commit"), &GDScriptBytecodeCompiler::get_commit);
+
+	ClassDB::bind_method(D_METHOD("compile_code_string", "code"), &GDScriptBytecodeCompiler::compile_code_string);
+	ClassDB::bind_method(D_METHOD("compile_files", "paths", "output_dir", "threads", "key"), &GDScriptBytecodeCompiler::compile_files, DEFVAL(-1), DEFVAL(Vector<uint8_t>()));
+	ClassDB::bind_method(D_METHOD("compile_dir", "source_dir", "output_dir", "threads", "key"), &GDScriptBytecodeCompiler::compile_dir, DEFVAL(-1), DEFVAL(Vector<uint8_t>()));
+	ClassDB::bind_method(D_METHOD("get_batch_errors"), &GDScriptBytecodeCompiler::get_batch_errors);
+	ClassDB::bind_method(D_METHOD("get_error_message"), &GDScriptBytecodeCompiler::get_error_message);
+}
+
+Error GDScriptBytecodeCompiler::set_version(const Variant &p_commit_or_version) {
+	if (decomp) {
+		memdelete(decomp);
+		decomp = nullptr;
+	}
+	keywords.clear();
+	type_names.clear();
+	function_names.clear();
+
+	decomp = GDScriptDecomp::create(p_commit_or_version);
+	ERR_FAIL_COND_V_MSG(!decomp, ERR_UNAVAILABLE, "No bytecode version for '" + String(p_commit_or_version) + "'.");
+
+	// Only the tokens the version can store are looked up, everything else stays an identifier
+	GDScriptBytecodeWriter writer(decomp);
+	for (uint32_t i = 0; i < sizeof(compiler_keywords) / sizeof(compiler_keywords[0]); i++) {
+		if (writer.has_token(compiler_keywords[i].token)) {
+			keywords.insert(compiler_keywords[i].text, compiler_keywords[i].token);
+		}
+	}
+	if (writer.has_token(GDScriptDecomp::G_TK_BUILT_IN_TYPE)) {
+		bool v2 = decomp->get_variant_ver_major() == 2;
+		int type_count = v2 ? V2Type::VARIANT_MAX : V3Type::VARIANT_MAX;
+		// Nil has no name in scripts
+		for (int i = 1; i < type_count; i++) {
+			type_names.insert(v2 ? GDScriptDecomp::get_type_name_v2(i) : GDScriptDecomp::get_type_name_v3(i), i);
+		}
+	}
+	if (writer.has_token(GDScriptDecomp::G_TK_BUILT_IN_FUNC)) {
+		for (int i = 0; i < decomp->get_function_count(); i++) {
+			function_names.insert(decomp->get_function_name(i), i);
+		}
+	}
+	return OK;
+}
+
+int64_t GDScriptBytecodeCompiler::get_commit() const {
+	return decomp ? decomp->get_commit() : 0;
+}
+
+Error GDScriptBytecodeCompiler::_tokenize(const String &p_code, GDScriptBytecodeWriter &r_writer, String &r_error) const {
+	const char32_t *src = p_code.get_data();
+	const int len = p_code.length();
+	const bool v4 = decomp->get_variant_ver_major() >= 4;
+
+	uint32_t line = 1;
+	uint32_t indent = 0;
+	int pos = 0;
+	int bracket_depth = 0;
+	bool line_start = true;
+	bool pending_newline = false;
+	GDScriptDecomp::GlobalToken prev = GDScriptDecomp::G_TK_NEWLINE;
+	Error err = OK;
+
+	while (pos < len) {
+		if (line_start) {
+			// Tabs and spaces count one each, like the 3.x tokenizer does it
+			indent = 0;
+			while (pos < len && (src[pos] == ' ' || src[pos] == '\t')) {
+				indent++;
+				pos++;
+			}
+			line_start = false;
+			continue;
+		}
+
+		char32_t c = src[pos];
+		if (c == '\n') {
+			line++;
+			pos++;
+			// Lines only end outside of brackets, blank lines never end one.
+			// Godot 4 keeps the position of every line, lambdas inside brackets depend on it.
+			if (bracket_depth == 0 || v4) {
+				line_start = true;
+				pending_newline = pending_newline || prev != GDScriptDecomp::G_TK_NEWLINE;
+			}
+			continue;
+		}
+		if (c == ' ' || c == '\t' || c == '\r') {
+			pos++;
+			continue;
+		}
+		if (c == '#') {
+			while (pos < len && src[pos] != '\n') {
+				pos++;
+			}
+			continue;
+		}
+		if (c == '\\') {
+			pos++;
+			if (pos < len && src[pos] == '\r') {
+				pos++;
+			}
+			if (pos >= len || src[pos] != '\n') {
+				r_error = itos(line) + ": " + RTR("Expected a new line after '\\'.");
+				return ERR_PARSE_ERROR;
+			}
+			pos++;
+			line++;
+			continue;
+		}
+
+		if (pending_newline) {
+			r_writer.set_line(line);
+			err = r_writer.add_token(GDScriptDecomp::G_TK_NEWLINE, indent);
+			if (err) {
+				break;
+			}
+			pending_newline = false;
+		}
+		r_writer.set_line(line);
+
+		// String literals, Godot 4 has prefixes for StringName, NodePath and raw strings
+		bool string_name = false;
+		bool node_path = false;
+		bool raw = false;
+		int quote_pos = pos;
+		if (pos + 1 < len && (src[pos + 1] == '"' || src[pos + 1] == '\'')) {
+			if (v4 && c == '&') {
+				string_name = true;
+			} else if ((v4 && c == '^') || (!v4 && c == '@')) {
+				node_path = true;
+			} else if (v4 && c == 'r') {
+				raw = true;
+			}
+			if (string_name || node_path || raw) {
+				quote_pos = pos + 1;
+			}
+		}
+		if (src[quote_pos] == '"' || src[quote_pos] == '\'') {
+			char32_t quote = src[quote_pos];
+			uint32_t start_line = line;
+			bool triple = quote_pos + 2 < len && src[quote_pos + 1] == quote && src[quote_pos + 2] == quote;
+			pos = quote_pos + (triple ? 3 : 1);
+
+			String str;
+			bool closed = false;
+			while (pos < len) {
+				char32_t sc = src[pos];
+				if (sc == quote && (!triple || (pos + 2 < len && src[pos + 1] == quote && src[pos + 2] == quote))) {
+					pos += triple ? 3 : 1;
+					closed = true;
+					break;
+				}
+				if (sc == '\n') {
+					if (!triple) {
+						break;
+					}
+					line++;
+				}
+				if (sc == '\\' && pos + 1 < len) {
+					char32_t esc = src[pos + 1];
+					if (raw) {
+						// Raw strings keep the backslash, it only stops the quote from ending the string
+						str += sc;
+						if (esc == quote || esc == '\\') {
+							str += esc;
+							pos++;
+						}
+						pos++;
+						continue;
+					}
+					pos += 2;
+					char32_t res = 0;
+					switch (esc) {
+						case 'a':
+							res = 7;
+							break;
+						case 'b':
+							res = 8;
+							break;
+						case 'f':
+							res = 12;
+							break;
+						case 'n':
+							res = 10;
+							break;
+						case 'r':
+							res = 13;
+							break;
+						case 't':
+							res = 9;
+							break;
+						case 'v':
+							res = 11;
+							break;
+						case '\'':
+						case '"':
+						case '\\':
+							res = esc;
+							break;
+						case '\n':
+							line++;
+							continue;
+						case 'u':
+						case 'U': {
+							int digits = esc == 'u' ? 4 : 6;
+							for (int i = 0; i < digits; i++) {
+								int v = pos < len ? _hex_digit(src[pos]) : -1;
+								if (v < 0) {
+									r_error = itos(line) + ": " + RTR("Invalid hexadecimal digit in unicode escape sequence.");
+									return ERR_PARSE_ERROR;
+								}
+								res = (res << 4) | v;
+								pos++;
+							}
+						} break;
+						default: {
+							r_error = itos(line) + ": " + RTR("Invalid escape in string.");
+							return ERR_PARSE_ERROR;
+						}
+					}
+					str += res;
+					continue;
+				}
+				str += sc;
+				pos++;
+			}
+			if (!closed) {
+				r_error = itos(start_line) + ": " + RTR("Unterminated string.");
+				return ERR_PARSE_ERROR;
+			}
+
+			if (string_name) {
+				err = r_writer.add_constant(StringName(str));
+			} else if (node_path) {
+				err = r_writer.add_constant(NodePath(str));
+			} else {
+				err = r_writer.add_constant(str);
+			}
+			if (err) {
+				break;
+			}
+			prev = GDScriptDecomp::G_TK_CONSTANT;
+			continue;
+		}
+
+		// Numbers, with the digit separators of newer versions
+		if (_is_digit(c) || (c == '.' && pos + 1 < len && _is_digit(src[pos + 1]))) {
+			int start = pos;
+			bool is_float = false;
+			bool is_hex = false;
+			bool is_bin = false;
+			if (c == '0' && pos + 1 < len && (src[pos + 1] == 'x' || src[pos + 1] == 'X')) {
+				is_hex = true;
+				pos += 2;
+				while (pos < len && (_hex_digit(src[pos]) >= 0 || src[pos] == '_')) {
+					pos++;
+				}
+			} else if (c == '0' && pos + 1 < len && (src[pos + 1] == 'b' || src[pos + 1] == 'B')) {
+				is_bin = true;
+				pos += 2;
+				while (pos < len && (src[pos] == '0' || src[pos] == '1' || src[pos] == '_')) {
+					pos++;
+				}
+			} else {
+				while (pos < len && (_is_digit(src[pos]) || src[pos] == '_')) {
+					pos++;
+				}
+				// A second period is the range operator or a method call on the number
+				if (pos < len && src[pos] == '.' && !(pos + 1 < len && (src[pos + 1] == '.' || _is_identifier_start(src[pos + 1])))) {
+					is_float = true;
+					pos++;
+					while (pos < len && (_is_digit(src[pos]) || src[pos] == '_')) {
+						pos++;
+					}
+				}
+				if (pos < len && (src[pos] == 'e' || src[pos] == 'E')) {
+					is_float = true;
+					pos++;
+					if (pos < len && (src[pos] == '+' || src[pos] == '-')) {
+						pos++;
+					}
+					while (pos < len && _is_digit(src[pos])) {
+						pos++;
+					}
+				}
+			}
+			if (pos < len && _is_identifier_char(src[pos])) {
+				r_error = itos(line) + ": " + RTR("Invalid numeric constant.");
+				return ERR_PARSE_ERROR;
+			}
+
+			String num = p_code.substr(start, pos - start).replace("_", "");
+			if (is_hex) {
+				err = r_writer.add_constant(num.hex_to_int());
+			} else if (is_bin) {
+				err = r_writer.add_constant(num.bin_to_int());
+			} else if (is_float) {
+				err = r_writer.add_constant(num.to_float());
+			} else {
+				err = r_writer.add_constant(num.to_int());
+			}
+			if (err) {
+				break;
+			}
+			prev = GDScriptDecomp::G_TK_CONSTANT;
+			continue;
+		}
+
+		// Annotations keep the '@' in their identifier
+		if (v4 && c == '@' && pos + 1 < len && _is_identifier_start(src[pos + 1])) {
+			int start = pos;
+			pos++;
+			while (pos < len && _is_identifier_char(src[pos])) {
+				pos++;
+			}
+			err = r_writer.add_identifier(p_code.substr(start, pos - start), GDScriptDecomp::G_TK_ANNOTATION);
+			if (err) {
+				break;
+			}
+			prev = GDScriptDecomp::G_TK_ANNOTATION;
+			continue;
+		}
+
+		if (_is_identifier_start(c)) {
+			int start = pos;
+			while (pos < len && _is_identifier_char(src[pos])) {
+				pos++;
+			}
+			String word = p_code.substr(start, pos - start);
+
+			// Members are never keywords
+			if (prev != GDScriptDecomp::G_TK_PERIOD) {
+				HashMap<String, GDScriptDecomp::GlobalToken>::ConstIterator K = keywords.find(word);
+				if (K) {
+					err = r_writer.add_token(K->value);
+					if (err) {
+						break;
+					}
+					prev = K->value;
+					continue;
+				}
+				if (word == "true" || word == "false" || word == "null") {
+					err = r_writer.add_constant(word == "null" ? Variant() : Variant(word == "true"));
+					if (err) {
+						break;
+					}
+					prev = GDScriptDecomp::G_TK_CONSTANT;
+					continue;
+				}
+				HashMap<String, int>::ConstIterator T = type_names.find(word);
+				if (T) {
+					err = r_writer.add_token(GDScriptDecomp::G_TK_BUILT_IN_TYPE, T->value);
+					if (err) {
+						break;
+					}
+					prev = GDScriptDecomp::G_TK_BUILT_IN_TYPE;
+					continue;
+				}
+				// Built-in functions only when called, so they can still be used as member names
+				HashMap<String, int>::ConstIterator F = function_names.find(word);
+				if (F) {
+					int next = pos;
+					while (next < len && (src[next] == ' ' || src[next] == '\t')) {
+						next++;
+					}
+					if (next < len && src[next] == '(') {
+						err = r_writer.add_token(GDScriptDecomp::G_TK_BUILT_IN_FUNC, F->value);
+						if (err) {
+							break;
+						}
+						prev = GDScriptDecomp::G_TK_BUILT_IN_FUNC;
+						continue;
+					}
+				}
+			}
+			err = r_writer.add_identifier(word);
+			if (err) {
+				break;
+			}
+			prev = GDScriptDecomp::G_TK_IDENTIFIER;
+			continue;
+		}
+
+		const CompilerKeyword *op = nullptr;
+		for (uint32_t i = 0; i < sizeof(compiler_operators) / sizeof(compiler_operators[0]); i++) {
+			const char *text = compiler_operators[i].text;
+			int op_len = strlen(text);
+			if (pos + op_len > len || !r_writer.has_token(compiler_operators[i].token)) {
+				continue;
+			}
+			int j = 0;
+			while (j < op_len && src[pos + j] == char32_t(text[j])) {
+				j++;
+			}
+			if (j == op_len) {
+				op = &compiler_operators[i];
+				break;
+			}
+		}
+		if (!op) {
+			r_error = itos(line) + ": " + RTR("Unexpected character.");
+			return ERR_PARSE_ERROR;
+		}
+		switch (op->token) {
+			case GDScriptDecomp::G_TK_BRACKET_OPEN:
+			case GDScriptDecomp::G_TK_CURLY_BRACKET_OPEN:
+			case GDScriptDecomp::G_TK_PARENTHESIS_OPEN: {
+				bracket_depth++;
+			} break;
+			case GDScriptDecomp::G_TK_BRACKET_CLOSE:
+			case GDScriptDecomp::G_TK_CURLY_BRACKET_CLOSE:
+			case GDScriptDecomp::G_TK_PARENTHESIS_CLOSE: {
+				if (bracket_depth == 0) {
+					r_error = itos(line) + ": " + RTR("Closing bracket without an opening one.");
+					return ERR_PARSE_ERROR;
+				}
+				bracket_depth--;
+			} break;
+			default:
+				break;
+		}
+		pos += strlen(op->text);
+		err = r_writer.add_token(op->token);
+		if (err) {
+			break;
+		}
+		prev = op->token;
+	}
+
+	if (err) {
+		r_error = itos(line) + ": " + RTR("Token or constant can't be stored in bytecode version") + " " + itos(decomp->get_bytecode_version()) + ".";
+		return err;
+	}
+	if (bracket_depth > 0) {
+		r_error = itos(line) + ": " + RTR("Unclosed bracket at the end of the file.");
+		return ERR_PARSE_ERROR;
+	}
+
+	// Scripts end with a line break and the end of file token, like the engine writes them
+	r_writer.set_line(line);
+	if (prev != GDScriptDecomp::G_TK_NEWLINE) {
+		r_writer.add_token(GDScriptDecomp::G_TK_NEWLINE, 0);
+	}
+	if (r_writer.has_token(GDScriptDecomp::G_TK_EOF)) {
+		r_writer.add_token(GDScriptDecomp::G_TK_EOF);
+	}
+	return OK;
+}
+
+Error GDScriptBytecodeCompiler::compile_code(const String &p_code, Vector<uint8_t> &r_bytecode) {
+	ERR_FAIL_COND_V_MSG(!decomp, ERR_UNCONFIGURED, "No bytecode version set.");
+	GDScriptBytecodeWriter writer(decomp);
+	Error err = _tokenize(p_code, writer, error_message);
+	if (err) {
+		return err;
+	}
+	r_bytecode = writer.get_bytecode();
+	error_message = RTR("No error");
+	return OK;
+}
+
+Vector<uint8_t> GDScriptBytecodeCompiler::compile_code_string(const String &p_code) {
+	Vector<uint8_t> bytecode;
+	compile_code(p_code, bytecode);
+	return bytecode;
+}
+
+String GDScriptBytecodeCompiler::get_error_message() const {
+	return error_message;
+}
+
+String GDScriptBytecodeCompiler::_compile_batch_file(uint32_t p_index, BatchCompileData *p_data, GDScriptBytecodeWriter &r_writer, LocalVector<uint8_t> &r_encrypted, CryptoCore::RandomGenerator &p_rng) const {
+	Error err;
+	String code = FileAccess::get_file_as_string(p_data->paths[p_index], &err);
+	if (err) {
+		return RTR("FileAccess error");
+	}
+
+	r_writer.clear();
+	String error;
+	if (_tokenize(code, r_writer, error) != OK) {
+		return error;
+	}
+	Vector<uint8_t> bytecode = r_writer.get_bytecode();
+	const uint8_t *data = bytecode.ptr();
+	uint64_t size = bytecode.size();
+	if (p_data->encrypt.is_key_set()) {
+		uint8_t iv[16];
+		if (p_rng.get_random_bytes(iv, 16) != OK || p_data->encrypt.encrypt_buffer(bytecode.ptr(), bytecode.size(), iv, r_encrypted) != OK) {
+			return RTR("Encryption error");
+		}
+		data = r_encrypted.ptr();
+		size = r_encrypted.size();
+	}
+
+	Ref<FileAccess> fa = FileAccess::open(p_data->targets[p_index], FileAccess::WRITE);
+	if (fa.is_null()) {
+		return RTR("FileAccess error");
+	}
+	fa->store_buffer(data, size);
+	return String();
+}
+
+void GDScriptBytecodeCompiler::_compile_files_worker(uint32_t p_worker, BatchCompileData *p_data) {
+	// The tables are shared, the writer and buffers belong to the worker and keep their capacity between files
+	GDScriptBytecodeWriter writer(decomp);
+	LocalVector<uint8_t> encrypted;
+	CryptoCore::RandomGenerator rng;
+	if (p_data->encrypt.is_key_set() && rng.init() != OK) {
+		ERR_PRINT("Failed to initialize the random generator for the encryption IVs.");
+		return;
+	}
+
+	while (!p_data->progress.cancelled.is_set()) {
+		uint32_t i = p_data->next_file.postincrement();
+		if (i >= (uint32_t)p_data->paths.size()) {
+			break;
+		}
+		p_data->errors[i] = _compile_batch_file(i, p_data, writer, encrypted, rng);
+		p_data->progress.done.increment();
+	}
+}
+
+Error GDScriptBytecodeCompiler::compile_files(const Vector<String> &p_paths, const String &p_output_dir, int p_threads, const Vector<uint8_t> &p_key) {
+	String ext = p_key.size() == 32 ? ".gde" : ".gdc";
+	Vector<String> targets;
+	targets.resize(p_paths.size());
+	for (int i = 0; i < p_paths.size(); i++) {
+		// Files from a pack keep their directory structure, loose files are written flat
+		String rel_path = p_paths[i].begins_with("res://") ? p_paths[i].replace_first("res://", "") : p_paths[i].get_file();
+		targets.write[i] = p_output_dir.plus_file(rel_path.get_basename() + ext);
+	}
+	return _compile_files(p_paths, targets, p_threads, p_key);
+}
+
+void GDScriptBytecodeCompiler::_find_scripts(const String &p_dir, const String &p_rel, Vector<String> &r_paths, Vector<String> &r_rel_paths) {
+	Ref<DirAccess> da = DirAccess::open(p_dir.plus_file(p_rel));
+	ERR_FAIL_COND(da.is_null());
+	da->list_dir_begin();
+	for (String f = da->get_next(); !f.is_empty(); f = da->get_next()) {
+		if (f == "." || f == "..") {
+			continue;
+		}
+		if (da->current_is_dir()) {
+			_find_scripts(p_dir, p_rel.plus_file(f), r_paths, r_rel_paths);
+		} else if (f.get_extension() == "gd") {
+			r_paths.push_back(p_dir.plus_file(p_rel).plus_file(f));
+			r_rel_paths.push_back(p_rel.plus_file(f));
+		}
+	}
+	da->list_dir_end();
+}
+
+Error GDScriptBytecodeCompiler::compile_dir(const String &p_source_dir, const String &p_output_dir, int p_threads, const Vector<uint8_t> &p_key) {
+	Vector<String> paths;
+	Vector<String> rel_paths;
+	_find_scripts(p_source_dir, String(), paths, rel_paths);
+
+	String ext = p_key.size() == 32 ? ".gde" : ".gdc";
+	Vector<String> targets;
+	targets.resize(paths.size());
+	for (int i = 0; i < paths.size(); i++) {
+		targets.write[i] = p_output_dir.plus_file(rel_paths[i].get_basename() + ext);
+	}
+	return _compile_files(paths, targets, p_threads, p_key);
+}
+
+Error GDScriptBytecodeCompiler::_compile_files(const Vector<String> &p_paths, const Vector<String> &p_targets, int p_threads, const Vector<uint8_t> &p_key) {
+	batch_errors.clear();
+	ERR_FAIL_COND_V_MSG(!decomp, ERR_UNCONFIGURED, "No bytecode version set.");
+	ERR_FAIL_COND_V_MSG(!p_key.is_empty() && p_key.size() != 32, ERR_INVALID_PARAMETER, "The encryption key must be 32 bytes, got " + itos(p_key.size()) + ".");
+	if (p_paths.is_empty()) {
+		return OK;
+	}
+
+	BatchCompileData data;
+	data.paths = p_paths;
+	data.targets = p_targets;
+	// The key schedule is set up once for the whole batch
+	if (!p_key.is_empty()) {
+		Error err = data.encrypt.set_key(p_key);
+		ERR_FAIL_COND_V_MSG(err != OK, err, "Failed to set up the encryption key.");
+	}
+
+	Ref<DirAccess> da = DirAccess::create(DirAccess::ACCESS_FILESYSTEM);
+	RBSet<String> dirs;
+	for (int i = 0; i < p_targets.size(); i++) {
+		String dir = p_targets[i].get_base_dir();
+		if (!dirs.has(dir)) {
+			dirs.insert(dir);
+			da->make_dir_recursive(dir);
+		}
+	}
+
+	Vector<String> errors;
+	errors.resize(p_paths.size());
+	errors.fill(RTR("Not compiled"));
+	data.errors = errors.ptrw();
+
+	int threads = p_threads > 0 ? p_threads : WorkerThreadPool::get_singleton()->get_thread_count();
+	threads = CLAMP(threads, 1, p_paths.size());
+	data.progress.func = batch_progress_func;
+	data.progress.userdata = batch_progress_userdata;
+	WorkerThreadPool::GroupID group_id = WorkerThreadPool::get_singleton()->add_template_group_task(this, &GDScriptBytecodeCompiler::_compile_files_worker, &data, threads, threads, true, "GDScriptBytecodeCompiler::compile_files");
+	data.progress.wait(group_id, p_paths.size());
+
+	for (int i = 0; i < errors.size(); i++) {
+		if (!errors[i].is_empty()) {
+			batch_errors[p_paths[i]] = errors[i];
+		}
+	}
+	return batch_errors.is_empty() ? OK : ERR_INVALID_DATA;
+}
+
+Dictionary GDScriptBytecodeCompiler::get_batch_errors() const {
+	return batch_errors;
+}
+
+void GDScriptBytecodeCompiler::set_batch_progress_func(GDScriptBatchProgress::Func p_func, void *p_userdata) {
+	batch_progress_func = p_func;
+	batch_progress_userdata = p_userdata;
+}
+
+GDScriptBytecodeCompiler::~GDScriptBytecodeCompiler() {
+	if (decomp) {
+		memdelete(decomp);
+	}
+}
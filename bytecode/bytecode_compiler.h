@@ -0,0 +1,82 @@
+/*************************************************************************/
+/*  bytecode_compiler.h                                                  */
+/*************************************************************************/
+
+#ifndef GDSCRIPT_BYTECODE_COMPILER_H
+#define GDSCRIPT_BYTECODE_COMPILER_H
+
+#include "bytecode_base.h"
+#include "bytecode_writer.h"
+#include "core/object/ref_counted.h"
+#include "core/templates/hash_map.h"
+
+// Inverse of GDScriptDecryptContext, writes the layout FileAccessEncrypted reads.
+class GDScriptEncryptContext {
+	enum {
+		HEADER_MAGIC = 0x43454447, // "GDEC"
+		HEADER_SIZE = 4 + 16 + 8 + 16, // magic, MD5, length, IV
+	};
+
+	mutable CryptoCore::AESContext aes;
+	bool key_set = false;
+
+public:
+	Error set_key(const Vector<uint8_t> &p_key);
+	bool is_key_set() const { return key_set; }
+	Error encrypt_buffer(const uint8_t *p_data, uint64_t p_len, const uint8_t p_iv[16], LocalVector<uint8_t> &r_buffer) const;
+};
+
+// Tokenizes GDScript source into the bytecode of one version, using the same tables as its decompiler.
+// Batches are compiled on the worker thread pool, every file is written with a single store.
+class GDScriptBytecodeCompiler : public RefCounted {
+	GDCLASS(GDScriptBytecodeCompiler, RefCounted);
+
+	// Tables of the target version, read only once set up so workers can share them
+	GDScriptDecomp *decomp = nullptr;
+	HashMap<String, GDScriptDecomp::GlobalToken> keywords;
+	HashMap<String, int> type_names;
+	HashMap<String, int> function_names;
+
+	String error_message;
+	Dictionary batch_errors;
+	GDScriptBatchProgress::Func batch_progress_func = nullptr;
+	void *batch_progress_userdata = nullptr;
+
+	Error _tokenize(const String &p_code, GDScriptBytecodeWriter &r_writer, String &r_error) const;
+
+	struct BatchCompileData {
+		Vector<String> paths;
+		Vector<String> targets;
+		GDScriptEncryptContext encrypt; // shared by all workers
+		String *errors = nullptr;
+		SafeNumeric<uint32_t> next_file;
+		GDScriptBatchProgress progress;
+	};
+	String _compile_batch_file(uint32_t p_index, BatchCompileData *p_data, GDScriptBytecodeWriter &r_writer, LocalVector<uint8_t> &r_encrypted, CryptoCore::RandomGenerator &p_rng) const;
+	void _compile_files_worker(uint32_t p_worker, BatchCompileData *p_data);
+	Error _compile_files(const Vector<String> &p_paths, const Vector<String> &p_targets, int p_threads, const Vector<uint8_t> &p_key);
+	static void _find_scripts(const String &p_dir, const String &p_rel, Vector<String> &r_paths, Vector<String> &r_rel_paths);
+
+protected:
+	static void _bind_methods();
+
+public:
+	Error set_version(const Variant &p_commit_or_version);
+	int64_t get_commit() const;
+
+	Error compile_code(const String &p_code, Vector<uint8_t> &r_bytecode);
+	Vector<uint8_t> compile_code_string(const String &p_code);
+	String get_error_message() const;
+
+	// Writes <name>.gdc to p_output_dir, or <name>.gde when a 32 byte key is given
+	Error compile_files(const Vector<String> &p_paths, const String &p_output_dir, int p_threads = -1, const Vector<uint8_t> &p_key = Vector<uint8_t>());
+	// Every .gd below p_source_dir, keeping the directory structure
+	Error compile_dir(const String &p_source_dir, const String &p_output_dir, int p_threads = -1, const Vector<uint8_t> &p_key = Vector<uint8_t>());
+	Dictionary get_batch_errors() const;
+	// Called while a batch runs, files not started when it returns true fail with "Not compiled"
+	void set_batch_progress_func(GDScriptBatchProgress::Func p_func, void *p_userdata);
+
+	~GDScriptBytecodeCompiler();
+};
+
+#endif
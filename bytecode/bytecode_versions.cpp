@@ -4,168 +4,230 @@
 
 #include "bytecode/bytecode_versions.h"
 
-void register_decomp_versions() {
-	ClassDB::register_class<GDScriptDecomp_f3f05dc>();
-	ClassDB::register_class<GDScriptDecomp_506df14>();
-	ClassDB::register_class<GDScriptDecomp_0b806ee>();
-	ClassDB::register_class<GDScriptDecomp_8c1731b>();
-	ClassDB::register_class<GDScriptDecomp_31ce3c5>();
-	ClassDB::register_class<GDScriptDecomp_703004f>();
-	ClassDB::register_class<GDScriptDecomp_8cab401>();
-	ClassDB::register_class<GDScriptDecomp_e82dc40>();
-	ClassDB::register_class<GDScriptDecomp_2185c01>();
-	ClassDB::register_class<GDScriptDecomp_97f34a1>();
-	ClassDB::register_class<GDScriptDecomp_be46be7>();
-	ClassDB::register_class<GDScriptDecomp_65d48d6>();
-	ClassDB::register_class<GDScriptDecomp_48f1d02>();
-	ClassDB::register_class<GDScriptDecomp_30c1229>();
-	ClassDB::register_class<GDScriptDecomp_7d2d144>();
-	ClassDB::register_class<GDScriptDecomp_64872ca>();
-	ClassDB::register_class<GDScriptDecomp_6174585>();
-	ClassDB::register_class<GDScriptDecomp_23441ec>();
-	ClassDB::register_class<GDScriptDecomp_7124599>();
-	ClassDB::register_class<GDScriptDecomp_1add52b>();
-	ClassDB::register_class<GDScriptDecomp_4ee82a2>();
-	ClassDB::register_class<GDScriptDecomp_513c026>();
-	ClassDB::register_class<GDScriptDecomp_23381a5>();
-	ClassDB::register_class<GDScriptDecomp_85585c7>();
-	ClassDB::register_class<GDScriptDecomp_ed80f45>();
-	ClassDB::register_class<GDScriptDecomp_8b912d1>();
-	ClassDB::register_class<GDScriptDecomp_62273e5>();
-	ClassDB::register_class<GDScriptDecomp_f8a7c46>();
-	ClassDB::register_class<GDScriptDecomp_c24c739>();
-	ClassDB::register_class<GDScriptDecomp_5e938f0>();
-	ClassDB::register_class<GDScriptDecomp_015d36d>();
-	ClassDB::register_class<GDScriptDecomp_c6120e7>();
-	ClassDB::register_class<GDScriptDecomp_d28da86>();
-	ClassDB::register_class<GDScriptDecomp_216a8aa>();
-	ClassDB::register_class<GDScriptDecomp_91ca725>();
-	ClassDB::register_class<GDScriptDecomp_054a2ac>();
-	ClassDB::register_class<GDScriptDecomp_ff1e7cf>();
-	ClassDB::register_class<GDScriptDecomp_a56d6ff>();
-	ClassDB::register_class<GDScriptDecomp_3ea6d9f>();
-	ClassDB::register_class<GDScriptDecomp_8e35d93>();
-	ClassDB::register_class<GDScriptDecomp_a3f1ee5>();
-	ClassDB::register_class<GDScriptDecomp_8aab9a0>();
-	ClassDB::register_class<GDScriptDecomp_d6b31da>();
-	ClassDB::register_class<GDScriptDecomp_1ca61a3>();
-	ClassDB::register_class<GDScriptDecomp_1a36141>();
-	ClassDB::register_class<GDScriptDecomp_514a3fb>();
-	ClassDB::register_class<GDScriptDecomp_7f7d97f>();
-	ClassDB::register_class<GDScriptDecomp_620ec47>();
-	ClassDB::register_class<GDScriptDecomp_c00427a>();
-	ClassDB::register_class<GDScriptDecomp_a60f242>();
-	ClassDB::register_class<GDScriptDecomp_6694c11>();
-	ClassDB::register_class<GDScriptDecomp_5565f55>();
-}
+#include "core/io/file_access.h"
+#include "core/io/marshalls.h"
+#include "core/object/worker_thread_pool.h"
+#include "utility/gdre_settings.h"
 
 GDScriptDecomp *create_decomp_for_commit(uint64_t p_commit_hash) {
 	switch (p_commit_hash) {
-		case 0x0b806ee:
-			return memnew(GDScriptDecomp_0b806ee);
-		case 0x8c1731b:
-			return memnew(GDScriptDecomp_8c1731b);
-		case 0x31ce3c5:
-			return memnew(GDScriptDecomp_31ce3c5);
-		case 0x703004f:
-			return memnew(GDScriptDecomp_703004f);
-		case 0x8cab401:
-			return memnew(GDScriptDecomp_8cab401);
-		case 0xe82dc40:
-			return memnew(GDScriptDecomp_e82dc40);
-		case 0x2185c01:
-			return memnew(GDScriptDecomp_2185c01);
-		case 0x97f34a1:
-			return memnew(GDScriptDecomp_97f34a1);
-		case 0xbe46be7:
-			return memnew(GDScriptDecomp_be46be7);
-		case 0x65d48d6:
-			return memnew(GDScriptDecomp_65d48d6);
-		case 0x48f1d02:
-			return memnew(GDScriptDecomp_48f1d02);
-		case 0x30c1229:
-			return memnew(GDScriptDecomp_30c1229);
-		case 0x7d2d144:
-			return memnew(GDScriptDecomp_7d2d144);
-		case 0x64872ca:
-			return memnew(GDScriptDecomp_64872ca);
-		case 0x6174585:
-			return memnew(GDScriptDecomp_6174585);
-		case 0x23441ec:
-			return memnew(GDScriptDecomp_23441ec);
-		case 0x7124599:
-			return memnew(GDScriptDecomp_7124599);
-		case 0x1add52b:
-			return memnew(GDScriptDecomp_1add52b);
-		case 0x4ee82a2:
-			return memnew(GDScriptDecomp_4ee82a2);
-		case 0x513c026:
-			return memnew(GDScriptDecomp_513c026);
-		case 0x23381a5:
-			return memnew(GDScriptDecomp_23381a5);
-		case 0x85585c7:
-			return memnew(GDScriptDecomp_85585c7);
-		case 0xed80f45:
-			return memnew(GDScriptDecomp_ed80f45);
-		case 0x8b912d1:
-			return memnew(GDScriptDecomp_8b912d1);
-		case 0x62273e5:
-			return memnew(GDScriptDecomp_62273e5);
-		case 0xf8a7c46:
-			return memnew(GDScriptDecomp_f8a7c46);
-		case 0xc24c739:
-			return memnew(GDScriptDecomp_c24c739);
-		case 0x5e938f0:
-			return memnew(GDScriptDecomp_5e938f0);
-		case 0x015d36d:
-			return memnew(GDScriptDecomp_015d36d);
-		case 0xc6120e7:
-			return memnew(GDScriptDecomp_c6120e7);
-		case 0xd28da86:
-			return memnew(GDScriptDecomp_d28da86);
-		case 0x216a8aa:
-			return memnew(GDScriptDecomp_216a8aa);
-		case 0x91ca725:
-			return memnew(GDScriptDecomp_91ca725);
-		case 0x054a2ac:
-			return memnew(GDScriptDecomp_054a2ac);
-		case 0xff1e7cf:
-			return memnew(GDScriptDecomp_ff1e7cf);
-		case 0xa56d6ff:
-			return memnew(GDScriptDecomp_a56d6ff);
-		case 0x3ea6d9f:
-			return memnew(GDScriptDecomp_3ea6d9f);
-		case 0x8e35d93:
-			return memnew(GDScriptDecomp_8e35d93);
-		case 0xa3f1ee5:
-			return memnew(GDScriptDecomp_a3f1ee5);
-		case 0x8aab9a0:
-			return memnew(GDScriptDecomp_8aab9a0);
-		case 0xd6b31da:
-			return memnew(GDScriptDecomp_d6b31da);
-		case 0x1ca61a3:
-			return memnew(GDScriptDecomp_1ca61a3);
-		case 0x1a36141:
-			return memnew(GDScriptDecomp_1a36141);
-		case 0x514a3fb:
-			return memnew(GDScriptDecomp_514a3fb);
-		case 0x7f7d97f:
-			return memnew(GDScriptDecomp_7f7d97f);
-		case 0x620ec47:
-			return memnew(GDScriptDecomp_620ec47);
-		case 0xc00427a:
-			return memnew(GDScriptDecomp_c00427a);
-		case 0xa60f242:
-			return memnew(GDScriptDecomp_a60f242);
-		case 0x6694c11:
-			return memnew(GDScriptDecomp_6694c11);
-		case 0x5565f55:
-			return memnew(GDScriptDecomp_5565f55);
-		case 0x506df14:
-			return memnew(GDScriptDecomp_506df14);
-		case 0xf3f05dc:
-			return memnew(GDScriptDecomp_f3f05dc);
+#define CREATE_DECOMP_VERSION(m_commit) \
+	case 0x##m_commit:                  \
+		return memnew(GDScriptDecomp_##m_commit);
+		GDSCRIPT_DECOMP_VERSIONS(CREATE_DECOMP_VERSION)
+#undef CREATE_DECOMP_VERSION
 		default:
 			return NULL;
 	}
-}
\ No newline at end of file
+}
+
+// "3.1.1", "3.1.1-stable" and "3.1.1.stable" all give 0x030101, -1 if it isn't a version
+static int _parse_engine_version(const String &p_version) {
+	Vector<String> parts = p_version.get_slice("-", 0).split(".");
+	if (parts.size() < 2) {
+		return -1;
+	}
+	int ret = 0;
+	for (int i = 0; i < 3; i++) {
+		int num = 0;
+		if (i < parts.size() && parts[i].is_valid_int()) {
+			num = parts[i].to_int();
+		} else if (i < 2) {
+			return -1;
+		}
+		ret = (ret << 8) | CLAMP(num, 0, 255);
+	}
+	return ret;
+}
+
+static uint64_t _get_commit_for_engine_version(const String &p_version) {
+	int version = _parse_engine_version(p_version);
+	ERR_FAIL_COND_V_MSG(version < 0, 0, "Invalid engine version '" + p_version + "'.");
+	// Versions are listed newest first, releases spanning several versions start with the oldest one
+	for (int i = 0; decomp_versions[i].commit != 0; i++) {
+		const String &name = decomp_versions[i].name;
+		if (name.find(" release (") < 0) {
+			continue;
+		}
+		int release = _parse_engine_version(name.get_slice(" ", 0));
+		if (release >= 0 && (release >> 16) == (version >> 16) && release <= version) {
+			return decomp_versions[i].commit;
+		}
+	}
+	ERR_FAIL_V_MSG(0, "No bytecode version known for engine version '" + p_version + "'.");
+}
+
+GDScriptDecomp *GDScriptDecomp::create(const Variant &p_commit_or_version) {
+	uint64_t commit = 0;
+	if (p_commit_or_version.get_type() == Variant::INT) {
+		commit = (int64_t)p_commit_or_version;
+	} else if (p_commit_or_version.get_type() == Variant::STRING || p_commit_or_version.get_type() == Variant::STRING_NAME) {
+		String s = String(p_commit_or_version).strip_edges();
+		// Commits are written as in git ("1a36141") or with a 0x prefix, versions always have a dot
+		if (s.is_valid_hex_number(true) || (s.find(".") < 0 && s.is_valid_hex_number(false))) {
+			commit = s.hex_to_int();
+		} else {
+			commit = _get_commit_for_engine_version(s);
+			if (commit == 0) {
+				return nullptr;
+			}
+		}
+	} else {
+		ERR_FAIL_V_MSG(nullptr, "Expected a commit hash or an engine version.");
+	}
+	GDScriptDecomp *decomp = create_decomp_for_commit(commit);
+	ERR_FAIL_COND_V_MSG(!decomp, nullptr, "Unknown bytecode commit " + String::num_uint64(commit, 16) + ".");
+	return decomp;
+}
+
+struct DetectVersionData {
+	Vector<GDScriptDecomp *> candidates;
+	Vector<Vector<uint8_t>> samples;
+	float *scores = nullptr;
+};
+
+static void _score_candidate(void *p_userdata, uint32_t p_index) {
+	DetectVersionData *data = (DetectVersionData *)p_userdata;
+	int valid = 0;
+	int total = 0;
+	for (int i = 0; i < data->samples.size(); i++) {
+		int sample_valid;
+		int sample_total;
+		if (data->candidates[p_index]->test_bytecode(data->samples[i], sample_valid, sample_total) != OK) {
+			// Header or constants failed to decode, this can't be the right version
+			data->scores[p_index] = 0;
+			return;
+		}
+		valid += sample_valid;
+		total += sample_total;
+	}
+	data->scores[p_index] = total > 0 ? float(valid) / float(total) : 0;
+}
+
+static int _get_sample_bytecode_version(const Vector<uint8_t> &p_buffer) {
+	if (p_buffer.size() < 24 || p_buffer[0] != 'G' || p_buffer[1] != 'D' || p_buffer[2] != 'S' || p_buffer[3] != 'C') {
+		return -1;
+	}
+	return decode_uint32(&p_buffer.ptr()[4]);
+}
+
+static Vector<GDScriptDecomp::VersionScore> _detect_version_for_samples(const Vector<Vector<uint8_t>> &p_samples) {
+	Vector<GDScriptDecomp::VersionScore> ret;
+	DetectVersionData data;
+	int version = -1;
+	for (int i = 0; i < p_samples.size(); i++) {
+		int sample_version = _get_sample_bytecode_version(p_samples[i]);
+		if (sample_version < 0) {
+			continue;
+		}
+		if (version == -1) {
+			version = sample_version;
+		}
+		if (sample_version == version) {
+			data.samples.push_back(p_samples[i]);
+		}
+	}
+	ERR_FAIL_COND_V_MSG(data.samples.is_empty(), ret, "No valid bytecode to detect the version from.");
+
+	// Only versions writing the same bytecode_version header are candidates
+	Vector<int> orders;
+	for (int i = 0; decomp_versions[i].commit != 0; i++) {
+		GDScriptDecomp *decomp = create_decomp_for_commit(decomp_versions[i].commit);
+		if (!decomp) {
+			continue;
+		}
+		if (decomp->get_bytecode_version() != version) {
+			memdelete(decomp);
+			continue;
+		}
+		data.candidates.push_back(decomp);
+		orders.push_back(i);
+	}
+	if (data.candidates.is_empty()) {
+		return ret;
+	}
+
+	Vector<float> scores;
+	scores.resize(data.candidates.size());
+	data.scores = scores.ptrw();
+	WorkerThreadPool::GroupID group_id = WorkerThreadPool::get_singleton()->add_native_group_task(&_score_candidate, &data, data.candidates.size(), -1, true, "GDScriptDecomp::detect_version");
+	WorkerThreadPool::get_singleton()->wait_for_group_task_completion(group_id);
+
+	for (int i = 0; i < data.candidates.size(); i++) {
+		if (scores[i] > 0) {
+			GDScriptDecomp::VersionScore vs;
+			vs.commit = decomp_versions[orders[i]].commit;
+			vs.score = scores[i];
+			vs.order = orders[i];
+			ret.push_back(vs);
+		}
+		memdelete(data.candidates[i]);
+	}
+	ret.sort();
+	return ret;
+}
+
+Vector<GDScriptDecomp::VersionScore> GDScriptDecomp::detect_version(const Vector<uint8_t> &p_buffer) {
+	Vector<Vector<uint8_t>> samples;
+	samples.push_back(p_buffer);
+	return _detect_version_for_samples(samples);
+}
+
+Vector<GDScriptDecomp::VersionScore> GDScriptDecomp::detect_version_from_files(const Vector<String> &p_paths, int p_max_samples) {
+	ERR_FAIL_COND_V(p_max_samples <= 0, Vector<VersionScore>());
+	Vector<uint8_t> key = GDRESettings::get_singleton()->get_encryption_key();
+	Vector<String> paths;
+	for (int i = 0; i < p_paths.size(); i++) {
+		if (p_paths[i].get_extension().to_lower() == "gdc" || (p_paths[i].get_extension().to_lower() == "gde" && key.size() == 32)) {
+			paths.push_back(p_paths[i]);
+		}
+	}
+
+	GDScriptDecryptContext decrypt;
+	if (key.size() == 32) {
+		decrypt.set_key(key);
+	}
+
+	// Spread the samples over the whole list, a handful of scripts is enough to tell versions apart
+	Vector<Vector<uint8_t>> samples;
+	LocalVector<uint8_t> decrypted;
+	int sample_count = MIN(p_max_samples, paths.size());
+	for (int i = 0; i < sample_count; i++) {
+		const String &path = paths[(int64_t)i * paths.size() / sample_count];
+		Vector<uint8_t> buffer;
+		if (path.get_extension().to_lower() == "gde") {
+			uint64_t len;
+			if (decrypt.decrypt_file(path, decrypted, len) != OK) {
+				continue;
+			}
+			buffer.resize(len);
+			memcpy(buffer.ptrw(), decrypted.ptr(), len);
+		} else {
+			buffer = FileAccess::get_file_as_array(path);
+		}
+		if (!buffer.is_empty()) {
+			samples.push_back(buffer);
+		}
+	}
+	return _detect_version_for_samples(samples);
+}
+
+static Array _version_scores_to_array(const Vector<GDScriptDecomp::VersionScore> &p_scores) {
+	Array ret;
+	for (int i = 0; i < p_scores.size(); i++) {
+		Dictionary d;
+		d["commit"] = (int64_t)p_scores[i].commit;
+		d["name"] = decomp_versions[p_scores[i].order].name.strip_edges();
+		d["score"] = p_scores[i].score;
+		ret.push_back(d);
+	}
+	return ret;
+}
+
+Array GDScriptDecomp::_detect_version(const Vector<uint8_t> &p_buffer) {
+	return _version_scores_to_array(detect_version(p_buffer));
+}
+
+Array GDScriptDecomp::_detect_version_from_files(const Vector<String> &p_paths, int p_max_samples) {
+	return _version_scores_to_array(detect_version_from_files(p_paths, p_max_samples));
+}
@@ -0,0 +1,328 @@
+/*************************************************************************/
+/*  bytecode_writer.cpp                                                  */
+/*************************************************************************/
+
+#include "bytecode_writer.h"
+
+#include "core/io/marshalls.h"
+
+GDScriptBytecodeWriter::GDScriptBytecodeWriter(const GDScriptDecomp *p_decomp) {
+	decomp = p_decomp;
+	binary_tokens = decomp->get_variant_ver_major() >= 4;
+	for (int i = 0; i < GDScriptDecomp::G_TK_MAX; i++) {
+		token_ids[i] = -1;
+	}
+	const GDScriptDecomp::GlobalToken *table = decomp->get_token_table();
+	for (int i = decomp->get_token_count() - 1; i >= 0; i--) {
+		// Tokens that are never stored map to G_TK_MAX
+		if (table[i] < GDScriptDecomp::G_TK_MAX) {
+			token_ids[table[i]] = i;
+		}
+	}
+}
+
+bool GDScriptBytecodeWriter::has_token(GDScriptDecomp::GlobalToken p_token) const {
+	return token_ids[p_token] >= 0;
+}
+
+int GDScriptBytecodeWriter::find_function(const String &p_name) const {
+	for (int i = 0; i < decomp->get_function_count(); i++) {
+		if (p_name == decomp->get_function_name(i)) {
+			return i;
+		}
+	}
+	return -1;
+}
+
+Error GDScriptBytecodeWriter::add_token(GDScriptDecomp::GlobalToken p_token, uint32_t p_payload) {
+	ERR_FAIL_COND_V_MSG(token_ids[p_token] < 0, ERR_UNAVAILABLE, "Token not available in bytecode version " + itos(decomp->get_bytecode_version()) + ".");
+	ERR_FAIL_COND_V(p_payload > (0xFFFFFFFFU >> GDScriptDecomp::TOKEN_BITS), ERR_INVALID_PARAMETER);
+
+	if (binary_tokens) {
+		if (p_token == GDScriptDecomp::G_TK_NEWLINE) {
+			line_start = true;
+			line_indent = p_payload;
+			return OK;
+		}
+		return _add_binary_token(token_ids[p_token], p_payload);
+	}
+
+	if (current_line != last_line) {
+		line_data.push_back(token_count);
+		line_data.push_back(current_line);
+		last_line = current_line;
+	}
+
+	uint32_t token = token_ids[p_token] | (p_payload << GDScriptDecomp::TOKEN_BITS);
+	if (token < GDScriptDecomp::TOKEN_BYTE_MASK) {
+		token_data.push_back(token);
+	} else {
+		uint32_t ofs = token_data.size();
+		token_data.resize(ofs + 4);
+		encode_uint32(token | GDScriptDecomp::TOKEN_BYTE_MASK, &token_data[ofs]);
+	}
+	token_count++;
+	return OK;
+}
+
+Error GDScriptBytecodeWriter::_add_binary_token(uint32_t p_token_id, uint32_t p_payload) {
+	if (line_start) {
+		line_data.push_back(token_count);
+		line_data.push_back(current_line);
+		column_data.push_back(token_count);
+		column_data.push_back(line_indent * TAB_SIZE + 1);
+		line_start = false;
+	}
+
+	// Every token is followed by its line
+	uint32_t ofs = token_data.size();
+	if (p_payload) {
+		token_data.resize(ofs + 8);
+		encode_uint32(p_token_id | (p_payload << GDScriptDecomp::TOKEN_BITS) | GDScriptDecomp::TOKEN_BYTE_MASK, &token_data[ofs]);
+		ofs += 4;
+	} else {
+		token_data.resize(ofs + 5);
+		token_data[ofs] = p_token_id;
+		ofs += 1;
+	}
+	encode_uint32(current_line, &token_data[ofs]);
+	token_count++;
+	return OK;
+}
+
+// Annotations use the identifier table too, with the '@' kept in the name
+Error GDScriptBytecodeWriter::add_identifier(const String &p_name, GDScriptDecomp::GlobalToken p_token) {
+	HashMap<String, uint32_t>::Iterator E = identifier_map.find(p_name);
+	if (E) {
+		return add_token(p_token, E->value);
+	}
+	uint32_t idx = identifier_names.size();
+	identifier_names.push_back(p_name);
+	identifier_map.insert(p_name, idx);
+	return add_token(p_token, idx);
+}
+
+Error GDScriptBytecodeWriter::_encode_constant(const Variant &p_value) {
+	uint32_t ofs = constant_data.size();
+	if (binary_tokens) {
+		int len;
+		Error err = encode_variant(p_value, nullptr, len);
+		ERR_FAIL_COND_V(err != OK, err);
+		constant_data.resize(ofs + len);
+		return encode_variant(p_value, &constant_data[ofs], len);
+	}
+	bool v3 = decomp->get_variant_ver_major() >= 3;
+	switch (p_value.get_type()) {
+		case Variant::NIL: {
+			constant_data.resize(ofs + 4);
+			encode_uint32(0, &constant_data[ofs]);
+		} break;
+		case Variant::BOOL: {
+			constant_data.resize(ofs + 8);
+			encode_uint32(1, &constant_data[ofs]);
+			encode_uint32(bool(p_value), &constant_data[ofs + 4]);
+		} break;
+		case Variant::INT: {
+			int64_t val = p_value;
+			if (val == int64_t(int32_t(val))) {
+				constant_data.resize(ofs + 8);
+				encode_uint32(2, &constant_data[ofs]);
+				encode_uint32(int32_t(val), &constant_data[ofs + 4]);
+			} else {
+				ERR_FAIL_COND_V_MSG(!v3, ERR_INVALID_DATA, "64-bit integers need bytecode of Godot 3.0 or newer.");
+				constant_data.resize(ofs + 12);
+				encode_uint32(2 | ENCODE_FLAG_64, &constant_data[ofs]);
+				encode_uint64(val, &constant_data[ofs + 4]);
+			}
+		} break;
+		case Variant::FLOAT: {
+			double val = p_value;
+			if (!v3 || double(float(val)) == val) {
+				constant_data.resize(ofs + 8);
+				encode_uint32(3, &constant_data[ofs]);
+				encode_float(val, &constant_data[ofs + 4]);
+			} else {
+				constant_data.resize(ofs + 12);
+				encode_uint32(3 | ENCODE_FLAG_64, &constant_data[ofs]);
+				encode_double(val, &constant_data[ofs + 4]);
+			}
+		} break;
+		case Variant::STRING: {
+			CharString utf8 = String(p_value).utf8();
+			uint32_t len = utf8.length();
+			uint32_t pad = (4 - (len % 4)) % 4;
+			constant_data.resize(ofs + 8 + len + pad);
+			encode_uint32(4, &constant_data[ofs]);
+			encode_uint32(len, &constant_data[ofs + 4]);
+			memcpy(&constant_data[ofs + 8], utf8.get_data(), len);
+			memset(&constant_data[ofs + 8 + len], 0, pad);
+		} break;
+		case Variant::NODE_PATH: {
+			// Always the new format, the old one (a plain string) is rejected by the loaders
+			NodePath np = p_value;
+			int name_count = np.get_name_count();
+			int subname_count = np.get_subname_count();
+			constant_data.resize(ofs + 16);
+			encode_uint32(v3 ? 15 : 16, &constant_data[ofs]);
+			encode_uint32(uint32_t(name_count) | 0x80000000, &constant_data[ofs + 4]);
+			encode_uint32(subname_count, &constant_data[ofs + 8]);
+			encode_uint32(np.is_absolute() ? 1 : 0, &constant_data[ofs + 12]);
+			for (int i = 0; i < name_count + subname_count; i++) {
+				CharString utf8 = String(i < name_count ? np.get_name(i) : np.get_subname(i - name_count)).utf8();
+				uint32_t len = utf8.length();
+				uint32_t pad = (4 - (len % 4)) % 4;
+				uint32_t str_ofs = constant_data.size();
+				constant_data.resize(str_ofs + 4 + len + pad);
+				encode_uint32(len, &constant_data[str_ofs]);
+				memcpy(&constant_data[str_ofs + 4], utf8.get_data(), len);
+				memset(&constant_data[str_ofs + 4 + len], 0, pad);
+			}
+		} break;
+		default: {
+			ERR_FAIL_V_MSG(ERR_UNAVAILABLE, "Can't encode constants of type " + Variant::get_type_name(p_value.get_type()) + ".");
+		}
+	}
+	return OK;
+}
+
+Error GDScriptBytecodeWriter::add_constant(const Variant &p_value) {
+	HashMap<Variant, uint32_t, VariantHasher, VariantComparator>::Iterator E = constant_map.find(p_value);
+	if (E) {
+		return add_token(GDScriptDecomp::G_TK_CONSTANT, E->value);
+	}
+	Error err = _encode_constant(p_value);
+	ERR_FAIL_COND_V(err != OK, err);
+	uint32_t idx = constant_map.size();
+	constant_map.insert(p_value, idx);
+	return add_token(GDScriptDecomp::G_TK_CONSTANT, idx);
+}
+
+void GDScriptBytecodeWriter::set_line(uint32_t p_line) {
+	current_line = p_line;
+}
+
+uint32_t GDScriptBytecodeWriter::get_line() const {
+	return current_line;
+}
+
+uint32_t GDScriptBytecodeWriter::get_token_count() const {
+	return token_count;
+}
+
+void GDScriptBytecodeWriter::clear() {
+	identifier_names.clear();
+	identifier_map.clear();
+	constant_data.clear();
+	constant_map.clear();
+	token_data.clear();
+	line_data.clear();
+	column_data.clear();
+	token_count = 0;
+	current_line = 1;
+	last_line = 0;
+	line_start = true;
+	line_indent = 0;
+}
+
+Vector<uint8_t> GDScriptBytecodeWriter::_get_binary_tokens() const {
+	uint32_t identifier_size = 0;
+	for (int i = 0; i < identifier_names.size(); i++) {
+		identifier_size += 4 + identifier_names[i].length() * 4;
+	}
+
+	Vector<uint8_t> ret;
+	ret.resize(12 + 20 + identifier_size + constant_data.size() + (line_data.size() + column_data.size()) * 4 + token_data.size());
+	uint8_t *w = ret.ptrw();
+	w[0] = 'G';
+	w[1] = 'D';
+	w[2] = 'S';
+	w[3] = 'C';
+	encode_uint32(decomp->get_bytecode_version(), &w[4]);
+	encode_uint32(0, &w[8]); // not compressed
+	encode_uint32(identifier_names.size(), &w[12]);
+	encode_uint32(constant_map.size(), &w[16]);
+	encode_uint32(line_data.size() / 2, &w[20]);
+	encode_uint32(0, &w[24]);
+	encode_uint32(token_count, &w[28]);
+	w += 32;
+
+	for (int i = 0; i < identifier_names.size(); i++) {
+		const String &name = identifier_names[i];
+		encode_uint32(name.length(), w);
+		w += 4;
+		for (int j = 0; j < name.length(); j++) {
+			encode_uint32(uint32_t(name[j]) ^ 0xb6b6b6b6, w);
+			w += 4;
+		}
+	}
+
+	if (constant_data.size()) {
+		memcpy(w, constant_data.ptr(), constant_data.size());
+		w += constant_data.size();
+	}
+	for (uint32_t i = 0; i < line_data.size(); i++) {
+		encode_uint32(line_data[i], w);
+		w += 4;
+	}
+	for (uint32_t i = 0; i < column_data.size(); i++) {
+		encode_uint32(column_data[i], w);
+		w += 4;
+	}
+	if (token_data.size()) {
+		memcpy(w, token_data.ptr(), token_data.size());
+	}
+	return ret;
+}
+
+Vector<uint8_t> GDScriptBytecodeWriter::get_bytecode() const {
+	if (binary_tokens) {
+		return _get_binary_tokens();
+	}
+
+	LocalVector<CharString> names;
+	uint32_t identifier_size = 0;
+	for (int i = 0; i < identifier_names.size(); i++) {
+		names.push_back(identifier_names[i].utf8());
+		// NUL terminated and padded to 4 bytes
+		identifier_size += 4 + ((names[i].length() + 4) & ~3);
+	}
+
+	Vector<uint8_t> ret;
+	ret.resize(24 + identifier_size + constant_data.size() + line_data.size() * 4 + token_data.size());
+	uint8_t *w = ret.ptrw();
+	w[0] = 'G';
+	w[1] = 'D';
+	w[2] = 'S';
+	w[3] = 'C';
+	encode_uint32(decomp->get_bytecode_version(), &w[4]);
+	encode_uint32(identifier_names.size(), &w[8]);
+	encode_uint32(constant_map.size(), &w[12]);
+	encode_uint32(line_data.size() / 2, &w[16]);
+	encode_uint32(token_count, &w[20]);
+	w += 24;
+
+	for (uint32_t i = 0; i < names.size(); i++) {
+		const char *name = names[i].get_data();
+		uint32_t len = names[i].length();
+		uint32_t padded = (len + 4) & ~3;
+		encode_uint32(padded, w);
+		w += 4;
+		for (uint32_t j = 0; j < padded; j++) {
+			w[j] = (j < len ? uint8_t(name[j]) : 0) ^ 0xb6;
+		}
+		w += padded;
+	}
+
+	if (constant_data.size()) {
+		memcpy(w, constant_data.ptr(), constant_data.size());
+		w += constant_data.size();
+	}
+	for (uint32_t i = 0; i < line_data.size(); i++) {
+		encode_uint32(line_data[i], w);
+		w += 4;
+	}
+	if (token_data.size()) {
+		memcpy(w, token_data.ptr(), token_data.size());
+	}
+	return ret;
+}
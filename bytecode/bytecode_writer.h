@@ -0,0 +1,58 @@
+/*************************************************************************/
+/*  bytecode_writer.h                                                    */
+/*************************************************************************/
+
+#ifndef GDSCRIPT_BYTECODE_WRITER_H
+#define GDSCRIPT_BYTECODE_WRITER_H
+
+#include "bytecode_base.h"
+#include "core/templates/hash_map.h"
+#include "core/templates/local_vector.h"
+
+// Builds a .gdc buffer for the bytecode version of a GDScriptDecomp, the inverse of _load_bytecode.
+// Tokens are given as GlobalToken and mapped back onto the version's own token ids.
+// For Godot 4 an uncompressed tokenizer buffer is written, newlines only set the line and column of the next token.
+class GDScriptBytecodeWriter {
+	enum {
+		TAB_SIZE = 4, // columns per indentation level, as the Godot 4 tokenizer counts them
+	};
+
+	const GDScriptDecomp *decomp = nullptr;
+	bool binary_tokens = false;
+	int16_t token_ids[GDScriptDecomp::G_TK_MAX];
+
+	Vector<String> identifier_names;
+	HashMap<String, uint32_t> identifier_map;
+	LocalVector<uint8_t> constant_data;
+	HashMap<Variant, uint32_t, VariantHasher, VariantComparator> constant_map;
+	LocalVector<uint8_t> token_data;
+	LocalVector<uint32_t> line_data; // token index, line
+	LocalVector<uint32_t> column_data; // token index, column
+	uint32_t token_count = 0;
+	uint32_t current_line = 1;
+	uint32_t last_line = 0;
+	bool line_start = true;
+	uint32_t line_indent = 0;
+
+	Error _add_binary_token(uint32_t p_token_id, uint32_t p_payload);
+	Error _encode_constant(const Variant &p_value);
+	Vector<uint8_t> _get_binary_tokens() const;
+
+public:
+	bool has_token(GDScriptDecomp::GlobalToken p_token) const;
+	int find_function(const String &p_name) const;
+
+	Error add_token(GDScriptDecomp::GlobalToken p_token, uint32_t p_payload = 0);
+	Error add_identifier(const String &p_name, GDScriptDecomp::GlobalToken p_token = GDScriptDecomp::G_TK_IDENTIFIER);
+	Error add_constant(const Variant &p_value);
+	void set_line(uint32_t p_line);
+	uint32_t get_line() const;
+	uint32_t get_token_count() const;
+
+	void clear();
+	Vector<uint8_t> get_bytecode() const;
+
+	GDScriptBytecodeWriter(const GDScriptDecomp *p_decomp);
+};
+
+#endif
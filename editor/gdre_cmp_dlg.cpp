@@ -3,6 +3,7 @@
 /*************************************************************************/
 
 #include "gdre_cmp_dlg.h"
+#include "bytecode/bytecode_versions.h"
 
 ScriptCompDialog::ScriptCompDialog() {
 	set_title(RTR("Compile GDScript"));
@@ -51,6 +52,16 @@ ScriptCompDialog::ScriptCompDialog() {
 	script_vb->add_margin_child(RTR("Script files:"), file_list, true);
 	script_vb->add_child(file_list_hbc);
 
+	//Script version
+	scrver = memnew(OptionButton);
+
+	for (int i = 0; decomp_versions[i].commit != 0; i++) {
+		scrver->add_item(decomp_versions[i].name, decomp_versions[i].commit);
+	}
+
+	script_vb->add_margin_child(RTR("Script bytecode version:"), scrver);
+	scrver->connect("item_selected", callable_mp(this, &ScriptCompDialog::_bytcode_changed));
+
 	//Target directory
 	HBoxContainer *dir_hbc = memnew(HBoxContainer);
 	target_dir = memnew(LineEdit);
@@ -92,6 +103,10 @@ String ScriptCompDialog::get_target_dir() const {
 	return target_dir->get_text();
 }
 
+int ScriptCompDialog::get_bytecode_version() const {
+	return scrver->get_selected_id();
+}
+
 void ScriptCompDialog::_add_files_pressed() {
 	file_selection->popup_centered(Size2(600, 400));
 }
@@ -108,6 +123,10 @@ void ScriptCompDialog::_clear_pressed() {
 	_validate_input();
 }
 
+void ScriptCompDialog::_bytcode_changed(int p_id) {
+	_validate_input();
+}
+
 void ScriptCompDialog::_remove_file_pressed() {
 	Vector<int> items = file_list->get_selected_items();
 	for (int i = items.size() - 1; i >= 0; i--) {
@@ -137,6 +156,12 @@ void ScriptCompDialog::_validate_input() {
 		ok = false;
 	}
 
+	if (scrver->get_selected_id() == 0xfffffff) {
+		error_message += RTR("No bytecode version selected") + "\n";
+		script_key_error->add_theme_color_override("font_color", error_color);
+		ok = false;
+	}
+
 	script_key_error->set_text(error_message);
 
 	get_ok_button()->set_disabled(!ok);
@@ -158,6 +183,7 @@ void ScriptCompDialog::_notification(int p_notification) {
 void ScriptCompDialog::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("get_file_list"), &ScriptCompDialog::get_file_list);
 	ClassDB::bind_method(D_METHOD("get_target_dir"), &ScriptCompDialog::get_target_dir);
+	ClassDB::bind_method(D_METHOD("get_bytecode_version"), &ScriptCompDialog::get_bytecode_version);
 
 	ClassDB::bind_method(D_METHOD("_add_files_pressed"), &ScriptCompDialog::_add_files_pressed);
 	ClassDB::bind_method(D_METHOD("_add_files_request", "files"), &ScriptCompDialog::_add_files_request);
@@ -165,4 +191,5 @@ void ScriptCompDialog::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("_clear_pressed"), &ScriptCompDialog::_clear_pressed);
 	ClassDB::bind_method(D_METHOD("_dir_select_pressed"), &ScriptCompDialog::_dir_select_pressed);
 	ClassDB::bind_method(D_METHOD("_dir_select_request", "path"), &ScriptCompDialog::_dir_select_request);
+	ClassDB::bind_method(D_METHOD("_bytcode_changed", "id"), &ScriptCompDialog::_bytcode_changed);
 }
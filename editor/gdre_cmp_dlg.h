@@ -13,6 +13,7 @@
 #include "scene/gui/file_dialog.h"
 #include "scene/gui/item_list.h"
 #include "scene/gui/line_edit.h"
+#include "scene/gui/option_button.h"
 #include "scene/gui/spin_box.h"
 #include "scene/gui/text_edit.h"
 
@@ -35,6 +36,8 @@ class ScriptCompDialog : public AcceptDialog {
 	Button *remove_file;
 	Button *clear_files;
 
+	OptionButton *scrver;
+
 	Label *script_key_error;
 
 	LineEdit *target_dir;
@@ -47,6 +50,7 @@ class ScriptCompDialog : public AcceptDialog {
 	void _clear_pressed();
 	void _dir_select_pressed();
 	void _dir_select_request(const String &p_path);
+	void _bytcode_changed(int p_id);
 
 protected:
 	void _notification(int p_notification);
@@ -55,6 +59,7 @@ protected:
 public:
 	Vector<String> get_file_list() const;
 	String get_target_dir() const;
+	int get_bytecode_version() const;
 
 	ScriptCompDialog();
 	~ScriptCompDialog();
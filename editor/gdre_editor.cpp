@@ -10,6 +10,7 @@
 #include "modules/gdscript/gdscript_tokenizer.h"
 #include "modules/gdscript/gdscript_utility_functions.h"
 
+#include "bytecode/bytecode_compiler.h"
 #include "bytecode/bytecode_versions.h"
 
 #include "core/io/file_access_encrypted.h"
@@ -463,7 +464,6 @@ void GodotREEditor::init_gui(Control *p_control, HBoxContainer *p_menu, bool p_l
 		menu_popup = menu_button->get_popup();
 		menu_popup->add_icon_item(icons["REScript"], RTR("Decompile .GDC/.GDE script files..."), MENU_DECOMP_GDS);
 		menu_popup->add_icon_item(icons["REScript"], RTR("Compile .GD script files..."), MENU_COMP_GDS);
-		menu_popup->set_item_disabled(menu_popup->get_item_index(MENU_COMP_GDS), true); //TEMP RE-ENABLE WHEN IMPLEMENTED
 
 		menu_popup->connect("id_pressed", callable_mp(this, &GodotREEditor::menu_option_pressed));
 		p_menu->add_child(menu_button);
@@ -496,7 +496,6 @@ void GodotREEditor::init_gui(Control *p_control, HBoxContainer *p_menu, bool p_l
 		menu_popup->add_separator();
 		menu_popup->add_icon_item(icons["REScript"], RTR("Decompile .GDC/.GDE script files..."), MENU_DECOMP_GDS);
 		menu_popup->add_icon_item(icons["REScript"], RTR("Compile .GD script files..."), MENU_COMP_GDS);
-		menu_popup->set_item_disabled(menu_popup->get_item_index(MENU_COMP_GDS), true); //TEMP RE-ENABLE WHEN IMPLEMENTED
 		menu_popup->add_separator();
 		menu_popup->add_icon_item(icons["REResBT"], RTR("Convert binary resources to text..."), MENU_CONV_TO_TXT);
 		menu_popup->add_icon_item(icons["REResTB"], RTR("Convert text resources to binary..."), MENU_CONV_TO_BIN);
@@ -630,6 +629,11 @@ void GodotREEditor::show_warning(const String &p_text, const String &p_title, co
 /* Decompile                                                             */
 /*************************************************************************/
 
+static bool _batch_progress_step(void *p_userdata, int p_done, int p_total) {
+	EditorProgressGDDC *pr = (EditorProgressGDDC *)p_userdata;
+	return pr->step(itos(p_done) + "/" + itos(p_total), p_done, true);
+}
+
 void GodotREEditor::_decompile_files() {
 	Vector<String> files = script_dialog_d->get_file_list();
 	String dir = script_dialog_d->get_target_dir();
@@ -668,32 +672,12 @@ void GodotREEditor::_decompile_process() {
 	}
 
 	EditorProgressGDDC *pr = memnew(EditorProgressGDDC(ne_parent, "re_decompile", RTR("Decompiling files..."), files.size(), true));
+	dce->set_batch_progress_func(_batch_progress_step, pr);
+	dce->decompile_files(files, dir, -1, key);
+	Dictionary errors = dce->get_batch_errors();
 	for (int i = 0; i < files.size(); i++) {
-		print_warning(RTR("decompiling") + " " + files[i].get_file(), RTR("Decompile"));
-
-		String target_name = dir.plus_file(files[i].get_file().get_basename() + ".gd");
-
-		bool cancel = pr->step(files[i].get_file(), i, true);
-		if (cancel) {
-			break;
-		}
-
-		Error err;
-		if (files[i].ends_with(".gde")) {
-			err = dce->decompile_byte_code_encrypted(files[i], key);
-		} else {
-			err = dce->decompile_byte_code(files[i]);
-		}
-
-		if (err == OK) {
-			String scr = dce->get_script_text();
-			Ref<FileAccess> file = FileAccess::open(target_name, FileAccess::WRITE, &err);
-			if (err) {
-				failed_files += files[i] + " (FileAccess error)\n";
-			}
-			file->store_string(scr);
-		} else {
-			failed_files += files[i] + " (" + dce->get_error_message() + ")\n";
+		if (errors.has(files[i])) {
+			failed_files += files[i] + " (" + String(errors[files[i]]) + ")\n";
 		}
 	}
 
@@ -715,7 +699,7 @@ void GodotREEditor::_compile_files() {
 	Vector<String> files = script_dialog_c->get_file_list();
 	Vector<uint8_t> key = key_dialog->get_key();
 	String dir = script_dialog_c->get_target_dir();
-	String ext = (key.size() == 32) ? ".gde" : ".gds";
+	String ext = (key.size() == 32) ? ".gde" : ".gdc";
 
 	Ref<DirAccess> da = DirAccess::create(DirAccess::ACCESS_FILESYSTEM);
 	String overwrite_list = String();
@@ -736,55 +720,28 @@ void GodotREEditor::_compile_files() {
 }
 
 void GodotREEditor::_compile_process() {
-	/*
 	Vector<String> files = script_dialog_c->get_file_list();
-	Vector<uint8_t> key = key_dialog->get_key(); = script_dialog_c->get_key();
+	Vector<uint8_t> key = key_dialog->get_key();
 	String dir = script_dialog_c->get_target_dir();
-	String ext = (key.size() == 32) ? ".gde" : ".gdc";
+
+	print_warning("GDScriptBytecodeCompiler{" + itos(script_dialog_c->get_bytecode_version()) + "}", RTR("Compile"));
 
 	String failed_files;
+	Ref<GDScriptBytecodeCompiler> compiler;
+	compiler.instantiate();
 
-	EditorProgressGDDC *pr = memnew(EditorProgressGDDC(ne_parent, "re_compile", RTR("Compiling files..."), files.size(), true));
+	if (compiler->set_version(script_dialog_c->get_bytecode_version()) != OK) {
+		show_warning(failed_files, RTR("Compile"), RTR("Invalid bytecode version!"));
+		return;
+	}
 
+	EditorProgressGDDC *pr = memnew(EditorProgressGDDC(ne_parent, "re_compile", RTR("Compiling files..."), files.size(), true));
+	compiler->set_batch_progress_func(_batch_progress_step, pr);
+	compiler->compile_files(files, dir, -1, key);
+	Dictionary errors = compiler->get_batch_errors();
 	for (int i = 0; i < files.size(); i++) {
-
-		print_warning(RTR("compiling") + " " + files[i].get_file(), RTR("Compile"));
-		String target_name = dir.plus_file(files[i].get_file().get_basename() + ext);
-
-		bool cancel = pr->step(files[i].get_file(), i, true);
-		if (cancel) {
-			break;
-		}
-
-		Vector<uint8_t> file = FileAccess::get_file_as_array(files[i]);
-		if (file.size() > 0) {
-			String txt;
-			txt.parse_utf8((const char *)file.ptr(), file.size());
-			file = GDScriptTokenizerBuffer::parse_code_string(txt);
-
-			Ref<FileAccess> fa = FileAccess::open(target_name, FileAccess::WRITE);
-			if (fa) {
-				if (key.size() == 32) {
-					Ref<FileAccessEncrypted> fae;
-					fae.instantiate();
-					Error err = fae->open_and_parse(fa, key, FileAccessEncrypted::MODE_WRITE_AES256);
-					if (err == OK) {
-						fae->store_buffer(file.ptr(), file.size());
-						fae->close();
-					} else {
-						failed_files += files[i] + " (FileAccessEncrypted error)\n";
-					}
-					memdelete(fae);
-				} else {
-					fa->store_buffer(file.ptr(), file.size());
-					fa->close();
-					memdelete(fa);
-				}
-			} else {
-				failed_files += files[i] + " (FileAccess error)\n";
-			}
-		} else {
-			failed_files += files[i] + " (Empty file)\n";
+		if (errors.has(files[i])) {
+			failed_files += files[i] + " (" + String(errors[files[i]]) + ")\n";
 		}
 	}
 
@@ -795,7 +752,6 @@ void GodotREEditor::_compile_process() {
 	} else {
 		show_warning(RTR("No errors detected."), RTR("Compile"), RTR("The operation completed successfully!"));
 	}
-*/
 }
 
 /*************************************************************************/
@@ -0,0 +1,154 @@
+"""Functions used to generate source files during build time
+
+All such functions are invoked in a subprocess on Windows to prevent build flakiness.
+
+"""
+
+import json
+from io import StringIO
+from platform_methods import subprocess_main
+
+
+# Versions either list their full tables or the changes to the tables of a parent version.
+def _apply_delta(table, delta, commit):
+    table = list(table)
+    for old, new in delta.get("rename", {}).items():
+        if old not in table:
+            raise ValueError("{}: can't rename missing entry '{}'.".format(commit, old))
+        table[table.index(old)] = new
+    for name in delta.get("remove", []):
+        if name not in table:
+            raise ValueError("{}: can't remove missing entry '{}'.".format(commit, name))
+        table.remove(name)
+    for anchor, names in delta.get("insert_after", {}).items():
+        if anchor != "" and anchor not in table:
+            raise ValueError("{}: can't insert after missing entry '{}'.".format(commit, anchor))
+        pos = table.index(anchor) + 1 if anchor != "" else 0
+        table[pos:pos] = names
+    return table
+
+
+def _resolve_tables(versions):
+    by_commit = {}
+    for v in versions:
+        if v.get("commit") and not v.get("disabled"):
+            by_commit[v["commit"]] = v
+
+    resolved = {}
+
+    def resolve(commit):
+        if commit in resolved:
+            return resolved[commit]
+        v = by_commit[commit]
+        if "parent" in v:
+            parent = resolve(v["parent"])
+            tables = {
+                "tokens": _apply_delta(parent["tokens"], v.get("tokens", {}), commit),
+                "functions": _apply_delta(parent["functions"], v.get("functions", {}), commit),
+            }
+        else:
+            tables = {"tokens": v["tokens"], "functions": v["functions"]}
+        resolved[commit] = tables
+        return tables
+
+    for commit, v in by_commit.items():
+        if not v.get("custom"):
+            resolve(commit)
+    return resolved
+
+
+def make_bytecode_versions_action(target, source, env):
+
+    dst = target[0]
+    with open(str(source[0]), "r") as f:
+        versions = json.load(f)["versions"]
+    tables = _resolve_tables(versions)
+    active = [v for v in versions if v.get("commit") and not v.get("disabled")]
+
+    # Every function name is stored once, the versions keep offsets into it
+    name_offsets = {}
+    names_string = StringIO()
+    offset = 0
+    for v in active:
+        if v.get("custom"):
+            continue
+        for name in tables[v["commit"]]["functions"]:
+            if name not in name_offsets:
+                name_offsets[name] = offset
+                offset += len(name) + 1
+                names_string.write('\t"{}\\0"\n'.format(name))
+    if offset > 0xFFFF:
+        raise ValueError("Function names don't fit 16-bit offsets.")
+
+    s = StringIO()
+    s.write("/* THIS FILE IS GENERATED DO NOT EDIT */\n\n")
+    s.write("#ifndef _GDRE_BYTECODE_VERSIONS_H\n")
+    s.write("#define _GDRE_BYTECODE_VERSIONS_H\n\n")
+    s.write('#include "bytecode/bytecode_base.h"\n\n')
+    for v in active:
+        if v.get("custom"):
+            s.write('#include "bytecode/bytecode_{}.h"\n'.format(v["commit"]))
+    s.write("\n")
+
+    s.write("inline constexpr char gdscript_function_names[] = {\n")
+    s.write(names_string.getvalue())
+    s.write("};\n\n")
+
+    for v in active:
+        if v.get("custom"):
+            continue
+        commit = v["commit"]
+        t = tables[commit]
+        s.write("class GDScriptDecomp_{0} : public GDScriptDecomp {{\n".format(commit))
+        s.write("\tGDCLASS(GDScriptDecomp_{0}, GDScriptDecomp);\n\n".format(commit))
+        s.write("protected:\n")
+        s.write("\tstatic void _bind_methods(){};\n\n")
+        s.write("\tstatic constexpr int bytecode_version = {};\n".format(v["bytecode_version"]))
+        s.write("\tstatic constexpr int variant_ver_major = {};\n".format(v["variant_ver_major"]))
+        s.write("\tstatic constexpr uint16_t func_names[] = {\n")
+        for name in t["functions"]:
+            s.write("\t\t{}, // {}\n".format(name_offsets[name], name))
+        s.write("\t};\n")
+        s.write("\tstatic constexpr GlobalToken token_table[] = {\n")
+        for token in t["tokens"]:
+            s.write("\t\tG_TK_{},\n".format(token))
+        s.write("\t};\n\n")
+        s.write("public:\n")
+        s.write("\tvirtual uint64_t get_commit() const override {{ return 0x{}; }}\n".format(commit))
+        s.write("\tvirtual int get_bytecode_version() const override { return bytecode_version; }\n")
+        s.write("\tvirtual int get_variant_ver_major() const override { return variant_ver_major; }\n")
+        s.write("\tvirtual const GlobalToken *get_token_table() const override { return token_table; }\n")
+        s.write("\tvirtual int get_token_count() const override { return sizeof(token_table) / sizeof(token_table[0]); }\n")
+        s.write(
+            "\tvirtual const char *get_function_name(int p_func) const override { return gdscript_function_names + func_names[p_func]; }\n"
+        )
+        s.write("\tvirtual int get_function_count() const override { return sizeof(func_names) / sizeof(func_names[0]); }\n")
+        s.write("};\n\n")
+
+    s.write("#define GDSCRIPT_DECOMP_VERSIONS(m_func) \\\n")
+    for v in active:
+        s.write("\tm_func({}) \\\n".format(v["commit"]))
+    s.write("\n")
+
+    s.write("struct GDScriptDecompVersion {\n")
+    s.write("\tuint64_t commit;\n")
+    s.write("\tString name;\n")
+    s.write("};\n\n")
+    s.write("static GDScriptDecompVersion decomp_versions[] = {\n")
+    for v in versions:
+        commit = v["commit"] if v.get("commit") else "fffffff"
+        entry = "{{ 0x{}, {} }},".format(commit, json.dumps(v["name"]))
+        s.write("\t//{}\n".format(entry) if v.get("disabled") else "\t{}\n".format(entry))
+    s.write('\t{ 0x0000000, "-NULL-" },\n')
+    s.write("};\n\n")
+    s.write("#endif\n")
+
+    with open(str(dst), "w") as f:
+        f.write(s.getvalue())
+
+    s.close()
+    names_string.close()
+
+
+if __name__ == "__main__":
+    subprocess_main(globals())
@@ -5,7 +5,9 @@
 #include "register_types.h"
 #include "core/object/class_db.h"
 
-#include "bytecode/bytecode_versions.h"
+#include "bytecode/bytecode_benchmark.h"
+#include "bytecode/bytecode_base.h"
+#include "bytecode/bytecode_compiler.h"
 #include "editor/gdre_editor.h"
 #include "utility/gdre_cli_main.h"
 #include "utility/gdre_settings.h"
@@ -26,8 +28,11 @@ void initialize_gdsdecomp_module(ModuleInitializationLevel p_level) {
 		return;
 	}
 
+	// Versioned decompilers are created by GDScriptDecomp.create() and register themselves on first use
 	ClassDB::register_abstract_class<GDScriptDecomp>();
-	register_decomp_versions();
+	ClassDB::register_class<GDScriptDecompCache>();
+	ClassDB::register_class<GDScriptDecompBenchmark>();
+	ClassDB::register_class<GDScriptBytecodeCompiler>();
 
 	ClassDB::register_class<GodotREEditorStandalone>();
 	ClassDB::register_class<PckDumper>();
@@ -36,11 +41,7 @@ void initialize_gdsdecomp_module(ModuleInitializationLevel p_level) {
 	ClassDB::register_class<OggStreamLoaderCompat>();
 	ClassDB::register_class<TextureLoaderCompat>();
 	ClassDB::register_class<GDRECLIMain>();
-
-	ClassDB::register_class<PackDialog>();
-	ClassDB::register_class<NewPackDialog>();
-	ClassDB::register_class<ScriptCompDialog>();
-	ClassDB::register_class<ScriptDecompDialog>();
+	// The dialogs are only created by GodotREEditor, they register themselves when it builds its GUI
 
 #ifdef TOOLS_ENABLED
 	EditorNode::add_init_callback(&gdsdecomp_init_callback);
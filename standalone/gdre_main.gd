@@ -34,7 +34,7 @@ func export_imports(output_dir:String):
 			
 
 func test_decomp(fname):
-	var decomp = GDScriptDecomp_ed80f45.new()
+	var decomp = GDScriptDecomp.create("2.1.3")
 	var f = fname
 	if f.get_extension() == "gdc":
 		print("decompiling " + f)
@@ -54,7 +54,7 @@ func test_decomp(fname):
 				print("error failed to save "+ f)
 
 	
-func dump_files(exe_file:String, output_dir:String, enc_key:String = "") -> int:
+func dump_files(exe_file:String, output_dir:String, enc_key:String = "", preserve_lines:bool = false, cache_dir:String = "", incremental:bool = false) -> int:
 	var err:int = OK;
 	var pckdump = PckDumper.new()
 	print(exe_file)
@@ -67,66 +67,87 @@ func dump_files(exe_file:String, output_dir:String, enc_key:String = "") -> int:
 		ver_minor = pckdump.get_engine_version().split(".")[1].to_int()
 		var version:String = pckdump.get_engine_version()
 		print("Version: " + version)
-		err = pckdump.check_md5_all_files()
-		if err != OK:
-			print("Error md5")
-			pckdump.clear_data()
-			return err
-		err = pckdump.pck_dump_to_dir(output_dir)
+		# Checksums are verified on the bytes being extracted, mismatching files are set aside
+		if incremental:
+			err = pckdump.pck_dump_incremental(output_dir, PckDumper.CHECKSUM_FAIL_QUARANTINE)
+		else:
+			err = pckdump.pck_dump_and_verify(output_dir, PckDumper.CHECKSUM_FAIL_QUARANTINE)
+		if err == ERR_BUG:
+			# Only the mismatching files were set aside, the rest of the project is still recovered
+			var failed_files = pckdump.get_checksum_failed_files()
+			print("Checksum failed for %d files, moved to %s or not extracted:" % [failed_files.size(), output_dir.plus_file(".gdre_checksum_failed")])
+			for f in failed_files:
+				print("  " + f)
+			err = OK
 		if err != OK:
 			print("error dumping to dir")
 			pckdump.clear_data()
 			return err
 
 		var decomp;
-		# TODO: instead of doing this, run the detect bytecode script
-		if version.begins_with("1.0"):
-			decomp = GDScriptDecomp_e82dc40.new()
-		elif version.begins_with("1.1"):
-			decomp = GDScriptDecomp_65d48d6.new()
-		elif version.begins_with("2.0"):
-			decomp = GDScriptDecomp_23441ec.new()
-		elif version.begins_with("2.1"):
-			decomp = GDScriptDecomp_ed80f45.new()
-		elif version.begins_with("3.0"):
-			decomp = GDScriptDecomp_054a2ac.new()
-		elif version.begins_with("3.1"):
-			decomp = GDScriptDecomp_514a3fb.new()
-		elif version.begins_with("3.2"):
-			decomp = GDScriptDecomp_5565f55.new()
-		elif version.begins_with("3.3"):
-			decomp = GDScriptDecomp_5565f55.new()
-		elif version.begins_with("3.4"):
-			decomp = GDScriptDecomp_5565f55.new()
-		elif version.begins_with("3.5"):
-			decomp = GDScriptDecomp_5565f55.new()
+		var detected = GDScriptDecomp.detect_version_from_files(pckdump.get_loaded_files())
+		if detected.size() > 0:
+			decomp = GDScriptDecomp.create(detected[0]["commit"])
+			print("Script version " + detected[0]["name"] + " detected")
 		else:
+			decomp = GDScriptDecomp.create(version)
+		if decomp == null:
 			print("Unknown version, no decomp")
 			pckdump.clear_data()
 			return err
 
-		print("Script version "+ version.substr(0,3)+".x detected")
+		if detected.size() == 0:
+			print("Script version "+ version.substr(0,3)+".x detected")
 
+		decomp.set_preserve_line_numbers(preserve_lines)
+		var cache:GDScriptDecompCache = null
+		if cache_dir != "":
+			cache = GDScriptDecompCache.new()
+			if cache.open(cache_dir) == OK:
+				decomp.set_cache(cache)
+		if incremental:
+			decomp.decompile_pack_files_incremental(output_dir)
+			var report:Dictionary = decomp.get_change_report()
+			for key in ["added", "changed", "token_identical", "unchanged", "removed", "failed"]:
+				print("Scripts %s: %d" % [key, report[key].size()])
+			for f in report["added"] + report["changed"]:
+				print("  updated " + f)
+			for f in report["removed"]:
+				print("  removed " + f)
+		else:
+			decomp.decompile_pack_files(output_dir)
+		if cache != null:
+			print("Script cache: %d hits, %d misses" % [cache.get_hit_count(), cache.get_miss_count()])
+			cache.close()
+		var errors = decomp.get_batch_errors()
+		var extracted = {}
+		var rewritten = {}
+		if incremental:
+			# Compiled files only come back when the pack entry was extracted again, whatever the script manifest says
+			for f in pckdump.get_extracted_files():
+				extracted[f] = true
+			var report:Dictionary = decomp.get_change_report()
+			for f in report["added"] + report["changed"]:
+				rewritten[f] = true
+		var da:Directory = Directory.new()
+		da.open(output_dir)
 		for f in pckdump.get_loaded_files():
-			var da:Directory = Directory.new()
-			da.open(output_dir)
-			f = f.replace("res://", "")
-			if f.get_extension() == "gdc":
-				print("decompiling " + f)
-				if decomp.decompile_byte_code(output_dir.plus_file(f)) != OK: 
-					print("error decompiling " + f)
-				else:
-					var text = decomp.get_script_text()
-					var gdfile:File = File.new()
-					if gdfile.open(output_dir.plus_file(f.replace(".gdc",".gd")), File.WRITE) == OK:
-						gdfile.store_string(text)
-						gdfile.close()
-						da.remove(f)
-						if da.file_exists(f.replace(".gdc",".gd.remap")):
-							da.remove(f.replace(".gdc",".gd.remap"))
-						print("successfully decompiled " + f)
-					else:
-						print("error failed to save "+ f)
+			if f.get_extension() != "gdc" and f.get_extension() != "gde":
+				continue
+			if errors.has(f):
+				print("error decompiling " + f + ": " + errors[f])
+				continue
+			var remap = f.get_basename() + ".gd.remap"
+			if incremental and not extracted.has(f) and not extracted.has(remap):
+				continue
+			var path = f.replace("res://", "")
+			da.remove(path)
+			if da.file_exists(path.get_basename() + ".gd.remap"):
+				da.remove(path.get_basename() + ".gd.remap")
+			if incremental and not rewritten.has(f):
+				print("kept the previous decompiled output of " + path)
+			else:
+				print("successfully decompiled " + path)
 		decomp.free()
 	else:
 		print("ERROR: failed to load exe")
@@ -171,6 +192,47 @@ func print_import_info(output_dir: String):
 		print((ifo as ImportInfo).to_string())
 	importer.reset()
 
+func run_benchmark(output_file:String, max_threads:int = -1) -> int:
+	var bench = GDScriptDecompBenchmark.new()
+	print("Running decompiler benchmark, this can take a few minutes...")
+	var results:Dictionary = bench.run(5, max_threads)
+	if results.is_empty():
+		print("Error: benchmark failed")
+		return ERR_BUG
+	for shape in results["summary"]:
+		var s = results["summary"][shape]
+		print("%s: %.1f scripts/s, %.2f MB/s" % [shape, s["scripts_per_sec"], s["mb_per_sec"]])
+	for t in results["threads"]:
+		print("%d threads: %.1f scripts/s (%.2fx)" % [t["threads"], t["scripts_per_sec"], t["speedup"]])
+	var file:File = File.new()
+	if file.open(output_file, File.WRITE) != OK:
+		print("Error: failed to write " + output_file)
+		return ERR_FILE_CANT_WRITE
+	file.store_string(JSON.new().stringify(results, "\t"))
+	file.close()
+	print("Benchmark results written to " + output_file)
+	return OK
+
+func compile_scripts(source_dir:String, output_dir:String, version:String, enc_key:String = "", max_threads:int = -1) -> int:
+	var compiler = GDScriptBytecodeCompiler.new()
+	if compiler.set_version(version) != OK:
+		print("Error: unknown bytecode version " + version)
+		return ERR_INVALID_PARAMETER
+	var key:PackedByteArray = PackedByteArray()
+	if enc_key != "":
+		if enc_key.length() != 64:
+			print("Error: the key has to be 64 hex characters")
+			return ERR_INVALID_PARAMETER
+		for i in range(32):
+			key.append(("0x" + enc_key.substr(i * 2, 2)).hex_to_int())
+	var err = compiler.compile_dir(source_dir, output_dir, max_threads, key)
+	var errors:Dictionary = compiler.get_batch_errors()
+	for script in errors:
+		print("Error compiling " + script + ": " + errors[script])
+	if errors.is_empty():
+		print("Compiled all scripts to " + output_dir)
+	return err
+
 func print_usage():
 	print("Godot Reverse Engineering Tools")
 	print("")
@@ -184,6 +246,19 @@ func print_usage():
 	print("--output-dir=<DIR>\t\tOutput directory")
 	print("\nOptions:\n")
 	print("--key=<KEY>\t\tThe Key to use if PAK/EXE is encrypted (hex string)")
+	print("--preserve-lines\t\tKeep decompiled script statements on their original line numbers")
+	print("--cache-dir=<DIR>\t\tReuse scripts decompiled in earlier runs from this directory")
+	print("--incremental\t\tOnly extract files and decompile scripts that changed since the last extraction to the same output directory")
+	print("\nBenchmark options:")
+	print("Usage: GDRE_Tools.exe --no-window --benchmark=<OUTPUT_JSON> [--threads=<N>]")
+	print("")
+	print("--benchmark=<OUTPUT_JSON>\t\tMeasure decompiler throughput for every bytecode version and save the results")
+	print("--threads=<N>\t\tHighest thread count to measure (default: all cores)")
+	print("\nCompile options:")
+	print("Usage: GDRE_Tools.exe --no-window --compile=<DIR> --bytecode=<VERSION> --output-dir=<DIR> [--key=<KEY>] [--threads=<N>]")
+	print("")
+	print("--compile=<DIR>\t\tCompile every .gd script in this directory")
+	print("--bytecode=<VERSION>\t\tEngine version or bytecode commit hash to compile for")
 	#print("View Godot assets, extract Godot PAK files, and export Godot projects")
 
 func handle_cli():
@@ -192,6 +267,13 @@ func handle_cli():
 	var exe_file:String = ""
 	var output_dir: String = ""
 	var enc_key: String = ""
+	var preserve_lines: bool = false
+	var cache_dir: String = ""
+	var incremental: bool = false
+	var benchmark_file: String = ""
+	var max_threads: int = -1
+	var compile_dir: String = ""
+	var bytecode_version: String = ""
 	for i in range(args.size()):
 		var arg:String = args[i]
 		if arg == "--help":
@@ -203,6 +285,35 @@ func handle_cli():
 			output_dir = normalize_path(get_arg_value(arg))
 		elif arg.begins_with("--key"):
 			enc_key = get_arg_value(arg)
+		elif arg == "--preserve-lines":
+			preserve_lines = true
+		elif arg == "--incremental":
+			incremental = true
+		elif arg.begins_with("--cache-dir"):
+			cache_dir = normalize_path(get_arg_value(arg))
+		elif arg.begins_with("--benchmark"):
+			benchmark_file = normalize_path(get_arg_value(arg))
+		elif arg.begins_with("--threads"):
+			max_threads = int(get_arg_value(arg))
+		elif arg.begins_with("--compile"):
+			compile_dir = normalize_path(get_arg_value(arg))
+		elif arg.begins_with("--bytecode"):
+			bytecode_version = get_arg_value(arg)
+	if benchmark_file != "":
+		var main = GDRECLIMain.new()
+		run_benchmark(main.get_cli_abs_path(benchmark_file), max_threads)
+		get_tree().quit()
+		return
+	if compile_dir != "":
+		if output_dir == "" or bytecode_version == "":
+			print("Error: use --output-dir=<dir> and --bytecode=<version> when using --compile")
+			print("")
+			print_usage()
+		else:
+			var main = GDRECLIMain.new()
+			compile_scripts(main.get_cli_abs_path(compile_dir), main.get_cli_abs_path(output_dir), bytecode_version, enc_key, max_threads)
+		get_tree().quit()
+		return
 	if exe_file != "":
 		if output_dir == "":
 			print("Error: use --output-dir=<dir> when using --extract")
@@ -216,7 +327,9 @@ func handle_cli():
 			#debugging
 			#print_import_info(output_dir)
 			#print_import_info_from_pak(exe_file)
-			var err = dump_files(exe_file, output_dir, enc_key)
+			if cache_dir != "":
+				cache_dir = main.get_cli_abs_path(cache_dir)
+			var err = dump_files(exe_file, output_dir, enc_key, preserve_lines, cache_dir, incremental)
 			if (err == OK):
 				export_imports(output_dir)
 			else:
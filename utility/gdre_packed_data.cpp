@@ -5,12 +5,227 @@
 #include "core/version.h"
 #include "gdre_settings.h"
 
+#if defined(WINDOWS_ENABLED)
+#include <windows.h>
+#elif defined(UNIX_ENABLED)
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
+#endif
+#include <stdint.h>
+
+Error GDREPackMapping::map(const String &p_path) {
+	ERR_FAIL_COND_V(data, ERR_ALREADY_IN_USE);
+#if defined(WINDOWS_ENABLED)
+	HANDLE file = CreateFileW((LPCWSTR)(p_path.utf16().get_data()), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		return ERR_FILE_CANT_OPEN;
+	}
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart <= 0 || (uint64_t)file_size.QuadPart > SIZE_MAX) {
+		CloseHandle(file);
+		return ERR_UNAVAILABLE;
+	}
+	// The view keeps the mapping and the file open
+	HANDLE map_handle = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	CloseHandle(file);
+	if (!map_handle) {
+		return ERR_UNAVAILABLE;
+	}
+	void *ptr = MapViewOfFile(map_handle, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(map_handle);
+	if (!ptr) {
+		return ERR_UNAVAILABLE;
+	}
+	data = (const uint8_t *)ptr;
+	size = file_size.QuadPart;
+	return OK;
+#elif defined(UNIX_ENABLED)
+	int file = ::open(p_path.utf8().get_data(), O_RDONLY | O_CLOEXEC);
+	if (file < 0) {
+		return ERR_FILE_CANT_OPEN;
+	}
+	struct stat st;
+	if (fstat(file, &st) != 0 || st.st_size <= 0 || (uint64_t)st.st_size > SIZE_MAX) {
+		::close(file);
+		return ERR_UNAVAILABLE;
+	}
+	void *ptr = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, file, 0);
+	if (ptr == MAP_FAILED) {
+		::close(file);
+		return ERR_UNAVAILABLE;
+	}
+	data = (const uint8_t *)ptr;
+	size = st.st_size;
+	// Kept open for kernel side copies, they read at explicit offsets so all threads can share it
+	fd = file;
+	return OK;
+#else
+	return ERR_UNAVAILABLE;
+#endif
+}
+
+GDREPackMapping::~GDREPackMapping() {
+	if (!data) {
+		return;
+	}
+#if defined(WINDOWS_ENABLED)
+	UnmapViewOfFile(data);
+#elif defined(UNIX_ENABLED)
+	munmap((void *)data, size);
+	::close(fd);
+#endif
+}
+
+Error FileAccessPackMapped::_open(const String &p_path, int p_mode_flags) {
+	ERR_FAIL_V(ERR_UNAVAILABLE);
+}
+
+bool FileAccessPackMapped::is_open() const {
+	return data != nullptr;
+}
+
+void FileAccessPackMapped::seek(uint64_t p_position) {
+	eof = p_position > length;
+	pos = p_position;
+}
+
+void FileAccessPackMapped::seek_end(int64_t p_position) {
+	seek(length + p_position);
+}
+
+uint64_t FileAccessPackMapped::get_position() const {
+	return pos;
+}
+
+uint64_t FileAccessPackMapped::get_length() const {
+	return length;
+}
+
+bool FileAccessPackMapped::eof_reached() const {
+	return eof;
+}
+
+uint8_t FileAccessPackMapped::get_8() const {
+	if (pos >= length) {
+		eof = true;
+		return 0;
+	}
+	return data[pos++];
+}
+
+uint64_t FileAccessPackMapped::get_buffer(uint8_t *p_dst, uint64_t p_length) const {
+	ERR_FAIL_COND_V(!p_dst && p_length > 0, -1);
+	if (eof) {
+		return 0;
+	}
+	uint64_t to_read = p_length;
+	if (pos >= length || to_read > length - pos) {
+		eof = true;
+		to_read = pos < length ? length - pos : 0;
+	}
+	memcpy(p_dst, data + pos, to_read);
+	pos += to_read;
+	return to_read;
+}
+
+Error FileAccessPackMapped::get_error() const {
+	if (eof) {
+		return ERR_FILE_EOF;
+	}
+	return OK;
+}
+
+void FileAccessPackMapped::flush() {
+	ERR_FAIL();
+}
+
+void FileAccessPackMapped::store_8(uint8_t p_dest) {
+	ERR_FAIL();
+}
+
+void FileAccessPackMapped::store_buffer(const uint8_t *p_src, uint64_t p_length) {
+	ERR_FAIL();
+}
+
+bool FileAccessPackMapped::file_exists(const String &p_name) {
+	return false;
+}
+
+const uint8_t *FileAccessPackMapped::get_view(const Ref<FileAccess> &p_file, uint64_t &r_length) {
+	FileAccessPackMapped *mapped = Object::cast_to<FileAccessPackMapped>(p_file.ptr());
+	if (!mapped) {
+		return nullptr;
+	}
+	r_length = mapped->length;
+	return mapped->data;
+}
+
+Error FileAccessPackMapped::copy_to_file(const Ref<FileAccess> &p_file, const String &p_target) {
+	FileAccessPackMapped *mapped = Object::cast_to<FileAccessPackMapped>(p_file.ptr());
+	if (!mapped || mapped->mapping->get_fd() < 0) {
+		return ERR_UNAVAILABLE;
+	}
+#ifdef __linux__
+	int out = ::open(p_target.utf8().get_data(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+	if (out < 0) {
+		return ERR_UNAVAILABLE;
+	}
+	// Reserves the whole file up front instead of growing it with every write, allowed to fail
+	if (mapped->length > 0) {
+		fallocate(out, 0, 0, mapped->length);
+	}
+	int in = mapped->mapping->get_fd();
+	loff_t in_offset = mapped->data - mapped->mapping->get_data();
+	uint64_t left = mapped->length;
+	bool use_sendfile = false;
+	while (left > 0) {
+		ssize_t copied;
+		if (!use_sendfile) {
+			copied = copy_file_range(in, &in_offset, out, nullptr, left, 0);
+			// Older kernels can't copy between filesystems
+			if (copied < 0 && left == mapped->length && (errno == EXDEV || errno == ENOSYS || errno == EINVAL || errno == EOPNOTSUPP)) {
+				use_sendfile = true;
+				continue;
+			}
+		} else {
+			off_t offset = in_offset;
+			copied = sendfile(out, in, &offset, MIN(left, (uint64_t)0x7ffff000));
+			in_offset = offset;
+		}
+		if (copied < 0 && errno == EINTR) {
+			continue;
+		}
+		if (copied <= 0) {
+			break;
+		}
+		left -= copied;
+	}
+	::close(out);
+	return left == 0 ? OK : ERR_UNAVAILABLE;
+#else
+	return ERR_UNAVAILABLE;
+#endif
+}
+
+FileAccessPackMapped::FileAccessPackMapped(const Ref<GDREPackMapping> &p_mapping, const PackedData::PackedFile &p_file) {
+	mapping = p_mapping;
+	data = mapping->get_data() + p_file.offset;
+	length = p_file.size;
+}
+
 bool GDREPackedSource::try_open_pack(const String &p_path, bool p_replace_files, uint64_t p_offset) {
 	String pck_path = p_path.replace("_GDRE_a_really_dumb_hack", "");
 	Ref<FileAccess> f = FileAccess::open(pck_path, FileAccess::READ);
 	if (f.is_null()) {
 		return false;
 	}
+	String pck_abs_path = f->get_path_absolute();
 
 	f->seek(p_offset);
 
@@ -129,8 +344,34 @@ bool GDREPackedSource::try_open_pack(const String &p_path, bool p_replace_files,
 		PackedData::get_singleton()->add_path(pck_path, path, ofs + p_offset, size, md5, this, p_replace_files, (flags & PACK_FILE_ENCRYPTED));
 	}
 
+	// Entries are read through FileAccessPack if the pack can't be mapped
+	Ref<GDREPackMapping> mapping;
+	mapping.instantiate();
+	if (mapping->map(pck_abs_path) == OK) {
+		mappings[pck_path] = mapping;
+	}
+
 	return true;
 }
+
 Ref<FileAccess> GDREPackedSource::get_file(const String &p_path, PackedData::PackedFile *p_file) {
-	return memnew(FileAccessPack(p_path, *p_file));
+	HashMap<String, Ref<GDREPackMapping>>::Iterator E = mappings.find(p_file->pack);
+	if (!E || p_file->offset > E->value->get_size() || p_file->size > E->value->get_size() - p_file->offset) {
+		return memnew(FileAccessPack(p_path, *p_file));
+	}
+	Ref<FileAccess> f = memnew(FileAccessPackMapped(E->value, *p_file));
+	if (p_file->encrypted) {
+		// Decrypted like FileAccessPack does, only the encrypted bytes come from the mapping
+		Ref<FileAccessEncrypted> fae;
+		fae.instantiate();
+		Vector<uint8_t> key;
+		key.resize(32);
+		for (int i = 0; i < key.size(); i++) {
+			key.write[i] = script_encryption_key[i];
+		}
+		Error err = fae->open_and_parse(f, key, FileAccessEncrypted::MODE_READ, false);
+		ERR_FAIL_COND_V_MSG(err, Ref<FileAccess>(), "Can't open encrypted pack-referenced file '" + p_path + "'.");
+		return fae;
+	}
+	return f;
 }
@@ -2,9 +2,74 @@
 #define GDRE_PACKED_DATA_H
 
 #include "core/object/ref_counted.h"
+#include "core/templates/hash_map.h"
 #include "packed_file_info.h"
 
+// Read-only mapping of a whole pack file, shared by every file opened from it.
+class GDREPackMapping : public RefCounted {
+	const uint8_t *data = nullptr;
+	uint64_t size = 0;
+	int fd = -1; // Unix only, kept open for kernel side copies
+
+public:
+	Error map(const String &p_path);
+	const uint8_t *get_data() const { return data; }
+	uint64_t get_size() const { return size; }
+	int get_fd() const { return fd; }
+
+	~GDREPackMapping();
+};
+
+// Pack entry read straight out of the mapped pack, without read syscalls.
+// Unencrypted entries also expose their bytes as a view, so they can be used without any copy.
+class FileAccessPackMapped : public FileAccess {
+	Ref<GDREPackMapping> mapping;
+	const uint8_t *data = nullptr;
+	uint64_t length = 0;
+	mutable uint64_t pos = 0;
+	mutable bool eof = false;
+
+	virtual Error _open(const String &p_path, int p_mode_flags) override;
+	virtual uint64_t _get_modified_time(const String &p_file) override { return 0; }
+	virtual uint32_t _get_unix_permissions(const String &p_file) override { return 0; }
+	virtual Error _set_unix_permissions(const String &p_file, uint32_t p_permissions) override { return FAILED; }
+
+public:
+	virtual bool is_open() const override;
+
+	virtual void seek(uint64_t p_position) override;
+	virtual void seek_end(int64_t p_position = 0) override;
+	virtual uint64_t get_position() const override;
+	virtual uint64_t get_length() const override;
+
+	virtual bool eof_reached() const override;
+
+	virtual uint8_t get_8() const override;
+	virtual uint64_t get_buffer(uint8_t *p_dst, uint64_t p_length) const override;
+
+	virtual Error get_error() const override;
+
+	virtual void flush() override;
+	virtual void store_8(uint8_t p_dest) override;
+	virtual void store_buffer(const uint8_t *p_src, uint64_t p_length) override;
+
+	virtual bool file_exists(const String &p_name) override;
+
+	// The whole entry, valid as long as the file is held
+	const uint8_t *get_data() const { return data; }
+	// nullptr unless p_file is an unencrypted entry of a mapped pack
+	static const uint8_t *get_view(const Ref<FileAccess> &p_file, uint64_t &r_length);
+	// Writes the entry to p_target without it passing through userland (copy_file_range or sendfile).
+	// ERR_UNAVAILABLE when the platform, the filesystems or p_file don't allow it, the file has to be written again then.
+	static Error copy_to_file(const Ref<FileAccess> &p_file, const String &p_target);
+
+	FileAccessPackMapped(const Ref<GDREPackMapping> &p_mapping, const PackedData::PackedFile &p_file);
+};
+
 class GDREPackedSource : public PackSource {
+	// Filled while opening packs, only read afterwards so files can be opened from any thread
+	HashMap<String, Ref<GDREPackMapping>> mappings;
+
 public:
 	virtual bool try_open_pack(const String &p_path, bool p_replace_files, uint64_t p_offset);
 	virtual Ref<FileAccess> get_file(const String &p_path, PackedData::PackedFile *p_file);
@@ -0,0 +1,154 @@
+#include "md5_multibuffer.h"
+
+#include "core/error/error_macros.h"
+
+#include <string.h>
+
+static const uint32_t md5_k[64] = {
+	0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a, 0xa8304613, 0xfd469501,
+	0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be, 0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821,
+	0xf61e2562, 0xc040b340, 0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+	0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8, 0x676f02d9, 0x8d2a4c8a,
+	0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c, 0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70,
+	0x289b7ec6, 0xeaa127fa, 0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+	0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92, 0xffeff47d, 0x85845dd1,
+	0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1, 0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391
+};
+
+static const uint8_t md5_s[64] = {
+	7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22, 7, 12, 17, 22,
+	5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20, 5, 9, 14, 20,
+	4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23, 4, 11, 16, 23,
+	6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21, 6, 10, 15, 21
+};
+
+// Message word used by each step
+static const uint8_t md5_g[64] = {
+	0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+	1, 6, 11, 0, 5, 10, 15, 4, 9, 14, 3, 8, 13, 2, 7, 12,
+	5, 8, 11, 14, 1, 4, 7, 10, 13, 0, 3, 6, 9, 12, 15, 2,
+	0, 7, 14, 5, 12, 3, 10, 1, 8, 15, 6, 13, 4, 11, 2, 9
+};
+
+#define MD5_F(m_b, m_c, m_d) ((m_d) ^ ((m_b) & ((m_c) ^ (m_d))))
+#define MD5_G(m_b, m_c, m_d) ((m_c) ^ ((m_d) & ((m_b) ^ (m_c))))
+#define MD5_H(m_b, m_c, m_d) ((m_b) ^ (m_c) ^ (m_d))
+#define MD5_I(m_b, m_c, m_d) ((m_c) ^ ((m_b) | ~(m_d)))
+
+// One round is 16 steps, each step is the same operation on every lane
+#define MD5_ROUND(m_func, m_first)                                              \
+	for (int i = m_first; i < m_first + 16; i++) {                              \
+		const uint32_t k = md5_k[i];                                            \
+		const int s = md5_s[i];                                                 \
+		const uint32_t *w = p_words[md5_g[i]];                                  \
+		for (int l = 0; l < MD5MultiBuffer::LANES; l++) {                       \
+			uint32_t f = a[l] + m_func(b[l], c[l], d[l]) + k + w[l];            \
+			a[l] = d[l];                                                        \
+			d[l] = c[l];                                                        \
+			c[l] = b[l];                                                        \
+			b[l] += (f << s) | (f >> (32 - s));                                 \
+		}                                                                       \
+	}
+
+static void _md5_compress(uint32_t (*r_state)[MD5MultiBuffer::LANES], const uint32_t (*p_words)[MD5MultiBuffer::LANES]) {
+	uint32_t a[MD5MultiBuffer::LANES];
+	uint32_t b[MD5MultiBuffer::LANES];
+	uint32_t c[MD5MultiBuffer::LANES];
+	uint32_t d[MD5MultiBuffer::LANES];
+	memcpy(a, r_state[0], sizeof(a));
+	memcpy(b, r_state[1], sizeof(b));
+	memcpy(c, r_state[2], sizeof(c));
+	memcpy(d, r_state[3], sizeof(d));
+
+	MD5_ROUND(MD5_F, 0)
+	MD5_ROUND(MD5_G, 16)
+	MD5_ROUND(MD5_H, 32)
+	MD5_ROUND(MD5_I, 48)
+
+	for (int l = 0; l < MD5MultiBuffer::LANES; l++) {
+		r_state[0][l] += a[l];
+		r_state[1][l] += b[l];
+		r_state[2][l] += c[l];
+		r_state[3][l] += d[l];
+	}
+}
+
+#undef MD5_ROUND
+#undef MD5_F
+#undef MD5_G
+#undef MD5_H
+#undef MD5_I
+
+void MD5MultiBuffer::hash(const uint8_t *const *p_data, const uint64_t *p_len, int p_count, uint8_t (*r_digests)[16]) {
+	ERR_FAIL_COND(p_count < 0 || p_count > LANES);
+
+	uint32_t state[4][LANES];
+	for (int l = 0; l < LANES; l++) {
+		state[0][l] = 0x67452301;
+		state[1][l] = 0xefcdab89;
+		state[2][l] = 0x98badcfe;
+		state[3][l] = 0x10325476;
+	}
+
+	// The last one or two blocks of each lane hold the end of its data and the padding
+	uint8_t tail[LANES][128];
+	uint64_t full_blocks[LANES] = {};
+	uint64_t total_blocks[LANES] = {};
+	uint64_t max_blocks = 0;
+	for (int l = 0; l < p_count; l++) {
+		full_blocks[l] = p_len[l] / 64;
+		uint32_t rem = p_len[l] % 64;
+		uint32_t tail_len = rem < 56 ? 64 : 128;
+		memcpy(tail[l], p_data[l] + full_blocks[l] * 64, rem);
+		tail[l][rem] = 0x80;
+		memset(tail[l] + rem + 1, 0, tail_len - rem - 1);
+		uint64_t bits = p_len[l] * 8;
+		for (int i = 0; i < 8; i++) {
+			tail[l][tail_len - 8 + i] = (bits >> (i * 8)) & 0xFF;
+		}
+		total_blocks[l] = full_blocks[l] + tail_len / 64;
+		max_blocks = MAX(max_blocks, total_blocks[l]);
+	}
+
+	static const uint8_t idle_block[64] = {};
+	uint32_t words[16][LANES];
+	for (uint64_t block = 0; block < max_blocks; block++) {
+		bool idle[LANES];
+		for (int l = 0; l < LANES; l++) {
+			const uint8_t *src;
+			idle[l] = block >= total_blocks[l];
+			if (idle[l]) {
+				src = idle_block;
+			} else if (block < full_blocks[l]) {
+				src = p_data[l] + block * 64;
+			} else {
+				src = tail[l] + (block - full_blocks[l]) * 64;
+			}
+			for (int i = 0; i < 16; i++) {
+				const uint8_t *w = src + i * 4;
+				words[i][l] = uint32_t(w[0]) | (uint32_t(w[1]) << 8) | (uint32_t(w[2]) << 16) | (uint32_t(w[3]) << 24);
+			}
+		}
+
+		uint32_t saved[4][LANES];
+		memcpy(saved, state, sizeof(state));
+		_md5_compress(state, words);
+		// Lanes that are already done keep their state
+		for (int l = 0; l < LANES; l++) {
+			if (idle[l]) {
+				for (int i = 0; i < 4; i++) {
+					state[i][l] = saved[i][l];
+				}
+			}
+		}
+	}
+
+	for (int l = 0; l < p_count; l++) {
+		for (int i = 0; i < 4; i++) {
+			r_digests[l][i * 4 + 0] = state[i][l] & 0xFF;
+			r_digests[l][i * 4 + 1] = (state[i][l] >> 8) & 0xFF;
+			r_digests[l][i * 4 + 2] = (state[i][l] >> 16) & 0xFF;
+			r_digests[l][i * 4 + 3] = (state[i][l] >> 24) & 0xFF;
+		}
+	}
+}
@@ -0,0 +1,19 @@
+#ifndef GDRE_MD5_MULTIBUFFER_H
+#define GDRE_MD5_MULTIBUFFER_H
+
+#include "core/typedefs.h"
+
+// MD5 of several independent buffers at once. The rounds of all lanes run in lockstep with the
+// words of each step laid out side by side, so the compiler turns every step into one SIMD operation.
+// Meant for many small files, where a single MD5 is one long dependency chain.
+class MD5MultiBuffer {
+public:
+	enum {
+		LANES = 4,
+	};
+
+	// p_count <= LANES, lanes of very different lengths idle once their buffer is done
+	static void hash(const uint8_t *const *p_data, const uint64_t *p_len, int p_count, uint8_t (*r_digests)[16]);
+};
+
+#endif // GDRE_MD5_MULTIBUFFER_H
@@ -7,73 +7,391 @@
 #include <core/io/dir_access.h>
 #include <core/io/file_access.h>
 #include <core/io/file_access_encrypted.h>
+#include <core/object/worker_thread_pool.h>
 #include <core/os/os.h>
+#include <core/templates/rb_set.h>
 #include <core/version_generated.gen.h>
 
 #include "core/crypto/crypto_core.h"
 #include "gdre_settings.h"
+#include "md5_multibuffer.h"
 
-bool PckDumper::_pck_file_check_md5(Ref<PackedFileInfo> &file) {
+bool PckDumper::_pck_file_check_md5(const Ref<PackedFileInfo> &file) {
 	// Loading an encrypted file automatically checks the md5
 	if (file->is_encrypted()) {
 		return true;
 	}
-	auto hash = FileAccess::get_md5(file->get_path());
-	auto p_md5 = String::md5(file->get_md5().ptr());
-	return hash == p_md5;
+	Ref<FileAccess> f = FileAccess::open(file->get_path(), FileAccess::READ);
+	if (f.is_null()) {
+		return false;
+	}
+	CryptoCore::MD5Context ctx;
+	ctx.start();
+	uint64_t len;
+	const uint8_t *view = FileAccessPackMapped::get_view(f, len);
+	if (view) {
+		// Hashed straight out of the mapped pack
+		ctx.update(view, len);
+	} else {
+		uint8_t buf[16384];
+		uint64_t got;
+		do {
+			got = f->get_buffer(buf, sizeof(buf));
+			ctx.update(buf, got);
+		} while (got == sizeof(buf));
+	}
+	unsigned char hash[16];
+	ctx.finish(hash);
+	return memcmp(hash, file->pf.md5, 16) == 0;
 }
 
 Error PckDumper::load_pck(const String &p_path) {
 	return GDRESettings::get_singleton()->load_pack(p_path);
 }
 
-Error PckDumper::check_md5_all_files() {
+void PckDumper::_check_md5_worker(uint32_t p_worker, MD5CheckData *p_data) {
+	LocalVector<uint8_t> buffers[MD5MultiBuffer::LANES];
+	while (true) {
+		uint32_t job = p_data->next_job.postincrement();
+		if (job >= p_data->job_count) {
+			break;
+		}
+		if (job < p_data->large_count) {
+			const Ref<PackedFileInfo> &file = p_data->files[p_data->order[job]];
+			file->set_md5_match(_pck_file_check_md5(file));
+			continue;
+		}
+
+		uint32_t first = p_data->large_count + (job - p_data->large_count) * MD5MultiBuffer::LANES;
+		int count = MIN((uint32_t)MD5MultiBuffer::LANES, p_data->order.size() - first);
+		Ref<FileAccess> f[MD5MultiBuffer::LANES];
+		const uint8_t *data[MD5MultiBuffer::LANES];
+		uint64_t len[MD5MultiBuffer::LANES];
+		for (int l = 0; l < count; l++) {
+			const Ref<PackedFileInfo> &file = p_data->files[p_data->order[first + l]];
+			f[l] = FileAccess::open(file->get_path(), FileAccess::READ);
+			data[l] = FileAccessPackMapped::get_view(f[l], len[l]);
+			if (!data[l]) {
+				buffers[l].resize(file->get_size());
+				len[l] = f[l].is_valid() ? f[l]->get_buffer(buffers[l].ptr(), buffers[l].size()) : 0;
+				data[l] = buffers[l].ptr();
+			}
+		}
+		uint8_t digests[MD5MultiBuffer::LANES][16];
+		MD5MultiBuffer::hash(data, len, count, digests);
+		for (int l = 0; l < count; l++) {
+			const Ref<PackedFileInfo> &file = p_data->files[p_data->order[first + l]];
+			file->set_md5_match(f[l].is_valid() && memcmp(digests[l], file->pf.md5, 16) == 0);
+		}
+	}
+}
+
+Error PckDumper::check_md5_all_files(int p_threads) {
+	struct SizeIndex {
+		uint64_t size;
+		uint32_t index;
+		bool operator<(const SizeIndex &p_other) const { return size < p_other.size; }
+	};
+
+	MD5CheckData data;
+	data.files = GDRESettings::get_singleton()->get_file_info_list();
+	Vector<SizeIndex> large_files;
+	Vector<SizeIndex> small_files;
+	for (int i = 0; i < data.files.size(); i++) {
+		const Ref<PackedFileInfo> &file = data.files[i];
+		if (file->is_encrypted()) {
+			// Loading an encrypted file automatically checks the md5
+			file->set_md5_match(true);
+		} else if (file->get_size() > MD5_SMALL_FILE_SIZE) {
+			large_files.push_back({ file->get_size(), (uint32_t)i });
+		} else {
+			small_files.push_back({ file->get_size(), (uint32_t)i });
+		}
+	}
+	// Biggest files first so no worker is left with a long one at the end
+	large_files.sort();
+	for (int i = large_files.size() - 1; i >= 0; i--) {
+		data.order.push_back(large_files[i].index);
+	}
+	data.large_count = data.order.size();
+	// Lanes of a group take about as long as each other
+	small_files.sort();
+	for (int i = 0; i < small_files.size(); i++) {
+		data.order.push_back(small_files[i].index);
+	}
+	data.job_count = data.large_count + (small_files.size() + MD5MultiBuffer::LANES - 1) / MD5MultiBuffer::LANES;
+
+	if (data.job_count > 0) {
+		int threads = p_threads > 0 ? p_threads : WorkerThreadPool::get_singleton()->get_thread_count();
+		threads = CLAMP(threads, 1, (int)data.job_count);
+		WorkerThreadPool::GroupID group_id = WorkerThreadPool::get_singleton()->add_template_group_task(this, &PckDumper::_check_md5_worker, &data, threads, threads, true, "PckDumper::check_md5_all_files");
+		WorkerThreadPool::get_singleton()->wait_for_group_task_completion(group_id);
+	}
+
 	Error err = OK;
-	auto files = GDRESettings::get_singleton()->get_file_info_list();
-	for (int i = 0; i < files.size(); i++) {
-		files.write[i]->set_md5_match(_pck_file_check_md5(files.write[i]));
-		if (files[i]->md5_passed) {
-			print_line("Verified " + files[i]->path);
+	for (int i = 0; i < data.files.size(); i++) {
+		if (data.files[i]->md5_passed) {
+			print_line("Verified " + data.files[i]->path);
 		} else {
-			print_error("Checksum failed for " + files[i]->path);
+			print_error("Checksum failed for " + data.files[i]->path);
 			err = ERR_BUG;
 		}
 	}
 	return err;
 }
 
-Error PckDumper::pck_dump_to_dir(const String &dir) {
+const char *PckDumper::QUARANTINE_DIR = ".gdre_checksum_failed";
+
+void PckDumper::_extract_files_worker(uint32_t p_worker, ExtractData *p_data) {
+	Ref<DirAccess> da;
+	while (true) {
+		uint32_t i = p_data->next_file.postincrement();
+		if (i >= (uint32_t)p_data->files.size()) {
+			break;
+		}
+		const Ref<PackedFileInfo> &file = p_data->files[i];
+		if (p_data->verify) {
+			file->set_md5_match(false);
+		}
+		// Every entry is opened with its own handle, FileAccess positions aren't shared between threads.
+		// Mapped packs only create a view into the shared mapping, otherwise the pack file is opened again.
+		Ref<FileAccess> pck_f = FileAccess::open(file->get_path(), FileAccess::READ);
+		if (pck_f.is_null()) {
+			if (p_data->verify && file->is_encrypted()) {
+				// FileAccessEncrypted checks the MD5 when it opens the file, there's nothing to set aside
+				p_data->errors[i] = "Checksum failed, can't be decrypted";
+				p_data->results[i] = ERR_BUG;
+			} else {
+				p_data->errors[i] = "FileAccess error";
+				p_data->results[i] = ERR_FILE_CANT_OPEN;
+			}
+			continue;
+		}
+		String target_name = p_data->dir.plus_file(file->get_path().replace("res://", ""));
+
+		// Encrypted files are checked by FileAccessEncrypted when they're opened
+		bool hash = p_data->verify && !file->is_encrypted();
+		CryptoCore::MD5Context ctx;
+		if (hash) {
+			ctx.start();
+		}
+		uint64_t view_size;
+		const uint8_t *view = FileAccessPackMapped::get_view(pck_f, view_size);
+		if (view) {
+			if (hash) {
+				ctx.update(view, view_size);
+			}
+			// Unencrypted entries are copied by the kernel, or written straight from the mapped pack
+			if (FileAccessPackMapped::copy_to_file(pck_f, target_name) != OK) {
+				Ref<FileAccess> fa = FileAccess::open(target_name, FileAccess::WRITE);
+				if (fa.is_null()) {
+					p_data->errors[i] = "FileWrite error";
+					p_data->results[i] = ERR_FILE_CANT_WRITE;
+					continue;
+				}
+				fa->store_buffer(view, view_size);
+				fa->flush();
+			}
+		} else {
+			Ref<FileAccess> fa = FileAccess::open(target_name, FileAccess::WRITE);
+			if (fa.is_null()) {
+				p_data->errors[i] = "FileWrite error";
+				p_data->results[i] = ERR_FILE_CANT_WRITE;
+				continue;
+			}
+			int64_t rq_size = file->get_size();
+			uint8_t buf[16384];
+			while (rq_size > 0) {
+				int got = pck_f->get_buffer(buf, MIN(16384, rq_size));
+				fa->store_buffer(buf, got);
+				if (hash) {
+					ctx.update(buf, got);
+				}
+				rq_size -= 16384;
+			}
+			fa->flush();
+		}
+		p_data->extracted.increment();
+		print_line("Extracted " + target_name);
+
+		if (!p_data->verify) {
+			continue;
+		}
+		bool passed = true;
+		if (hash) {
+			unsigned char md5[16];
+			ctx.finish(md5);
+			passed = memcmp(md5, file->pf.md5, 16) == 0;
+		}
+		file->set_md5_match(passed);
+		if (passed) {
+			continue;
+		}
+		p_data->results[i] = ERR_BUG;
+		if (p_data->fail_action == CHECKSUM_FAIL_KEEP) {
+			continue;
+		}
+		if (da.is_null()) {
+			da = DirAccess::create(DirAccess::ACCESS_FILESYSTEM);
+		}
+		if (p_data->fail_action == CHECKSUM_FAIL_DELETE) {
+			da->remove(target_name);
+			p_data->errors[i] = "Checksum failed, deleted";
+		} else {
+			String quarantine_name = p_data->dir.plus_file(QUARANTINE_DIR).plus_file(file->get_path().replace("res://", ""));
+			da->make_dir_recursive(quarantine_name.get_base_dir());
+			da->rename(target_name, quarantine_name);
+			p_data->errors[i] = "Checksum failed, moved to " + quarantine_name;
+		}
+	}
+}
+
+Error PckDumper::pck_dump_to_dir(const String &dir, int p_threads) {
+	return _pck_dump_to_dir(dir, p_threads, false, CHECKSUM_FAIL_KEEP, false);
+}
+
+Error PckDumper::pck_dump_and_verify(const String &dir, ChecksumFailAction p_fail_action, int p_threads) {
+	return _pck_dump_to_dir(dir, p_threads, true, p_fail_action, false);
+}
+
+Error PckDumper::pck_dump_incremental(const String &dir, ChecksumFailAction p_fail_action, int p_threads) {
+	return _pck_dump_to_dir(dir, p_threads, true, p_fail_action, true);
+}
+
+const char *PckDumper::PACK_MANIFEST_FILE = ".gdre_pack.manifest";
+
+Error PckDumper::_load_pack_manifest(const String &p_path, HashMap<String, String> &r_entries) {
+	Ref<FileAccess> f = FileAccess::open(p_path, FileAccess::READ);
+	if (f.is_null()) {
+		return ERR_FILE_NOT_FOUND;
+	}
+	uint8_t magic[4];
+	f->get_buffer(magic, 4);
+	uint32_t version = f->get_32();
+	ERR_FAIL_COND_V(magic[0] != 'G' || magic[1] != 'D' || magic[2] != 'P' || magic[3] != 'M' || version != PACK_MANIFEST_FORMAT_VERSION, ERR_FILE_UNRECOGNIZED);
+	uint32_t count = f->get_32();
+	for (uint32_t i = 0; i < count; i++) {
+		String path = f->get_pascal_string();
+		String md5 = f->get_pascal_string();
+		ERR_FAIL_COND_V(f->eof_reached(), ERR_FILE_CORRUPT);
+		r_entries[path] = md5;
+	}
+	return OK;
+}
+
+Error PckDumper::_save_pack_manifest(const String &p_path, const HashMap<String, String> &p_entries) {
+	Ref<FileAccess> f = FileAccess::open(p_path, FileAccess::WRITE);
+	ERR_FAIL_COND_V_MSG(f.is_null(), ERR_FILE_CANT_WRITE, "Can't write pack manifest '" + p_path + "'.");
+	f->store_buffer((const uint8_t *)"GDPM", 4);
+	f->store_32(PACK_MANIFEST_FORMAT_VERSION);
+	f->store_32(p_entries.size());
+	for (const KeyValue<String, String> &E : p_entries) {
+		f->store_pascal_string(E.key);
+		f->store_pascal_string(E.value);
+	}
+	return OK;
+}
+
+// Empty when the pack doesn't have the MD5 of the file
+static String _get_md5_string(const uint8_t *p_md5) {
+	for (int i = 0; i < 16; i++) {
+		if (p_md5[i] != 0) {
+			return String::hex_encode_buffer(p_md5, 16);
+		}
+	}
+	return String();
+}
+
+// Compiled scripts and their remaps are removed once the scripts are decompiled,
+// incremental runs don't extract them again as long as they didn't change
+static bool _is_replaced_by_decompiler(const String &p_path) {
+	String ext = p_path.get_extension().to_lower();
+	return ext == "gdc" || ext == "gde" || p_path.ends_with(".gd.remap");
+}
+
+Error PckDumper::_pck_dump_to_dir(const String &dir, int p_threads, bool p_verify, ChecksumFailAction p_fail_action, bool p_incremental) {
 	Ref<DirAccess> da = DirAccess::create(DirAccess::ACCESS_FILESYSTEM);
-	auto files = GDRESettings::get_singleton()->get_file_info_list();
-	Vector<uint8_t> key = get_key();
 	if (da.is_null()) {
 		return ERR_FILE_CANT_WRITE;
 	}
-	String failed_files;
-	Error err;
+	ExtractData data;
+	data.dir = dir;
+	data.verify = p_verify;
+	data.fail_action = p_fail_action;
+	checksum_failed_files.clear();
+	extracted_files.clear();
+	Vector<Ref<PackedFileInfo>> files = GDRESettings::get_singleton()->get_file_info_list();
+	if (files.is_empty()) {
+		print_line("No errors detected!");
+		return OK;
+	}
+
+	// Every dump records what it extracted, an incremental one leaves the files with the same MD5 alone
+	String manifest_path = dir.plus_file(PACK_MANIFEST_FILE);
+	HashMap<String, String> old_entries;
+	if (p_incremental && _load_pack_manifest(manifest_path, old_entries) != OK) {
+		old_entries.clear();
+	}
+	HashMap<String, String> new_entries;
 	for (int i = 0; i < files.size(); i++) {
-		Ref<FileAccess> pck_f = FileAccess::open(files.get(i)->get_path(), FileAccess::READ, &err);
-		if (pck_f.is_null()) {
-			failed_files += files.get(i)->get_path() + " (FileAccess error)\n";
-			continue;
+		String path = files[i]->get_path();
+		String md5 = _get_md5_string(files[i]->pf.md5);
+		HashMap<String, String>::Iterator E = old_entries.find(path);
+		if (E && !md5.is_empty() && E->value == md5 && (_is_replaced_by_decompiler(path) || FileAccess::exists(dir.plus_file(path.replace("res://", ""))))) {
+			new_entries[path] = md5;
+		} else {
+			data.files.push_back(files[i]);
 		}
-		String target_name = dir.plus_file(files.get(i)->get_path().replace("res://", ""));
-		da->make_dir_recursive(target_name.get_base_dir());
-		Ref<FileAccess> fa = FileAccess::open(target_name, FileAccess::WRITE);
-		if (fa.is_null()) {
-			failed_files += files.get(i)->get_path() + " (FileWrite error)\n";
-			continue;
+	}
+
+	// Each directory is created once, instead of once per file
+	RBSet<String> dirs;
+	for (int i = 0; i < data.files.size(); i++) {
+		String target_dir = dir.plus_file(data.files[i]->get_path().replace("res://", "")).get_base_dir();
+		if (!dirs.has(target_dir)) {
+			dirs.insert(target_dir);
+			da->make_dir_recursive(target_dir);
 		}
+	}
 
-		int64_t rq_size = files.get(i)->get_size();
-		uint8_t buf[16384];
-		while (rq_size > 0) {
-			int got = pck_f->get_buffer(buf, MIN(16384, rq_size));
-			fa->store_buffer(buf, got);
-			rq_size -= 16384;
+	Vector<String> errors;
+	errors.resize(data.files.size());
+	data.errors = errors.ptrw();
+	Vector<Error> results;
+	results.resize(data.files.size());
+	results.fill(OK);
+	data.results = results.ptrw();
+
+	if (!data.files.is_empty()) {
+		int threads = p_threads > 0 ? p_threads : WorkerThreadPool::get_singleton()->get_thread_count();
+		threads = CLAMP(threads, 1, data.files.size());
+		WorkerThreadPool::GroupID group_id = WorkerThreadPool::get_singleton()->add_template_group_task(this, &PckDumper::_extract_files_worker, &data, threads, threads, true, "PckDumper::pck_dump_to_dir");
+		WorkerThreadPool::get_singleton()->wait_for_group_task_completion(group_id);
+	}
+
+	Error err = OK;
+	bool checksum_failed = false;
+	String failed_files;
+	for (int i = 0; i < data.files.size(); i++) {
+		if (results[i] == ERR_BUG) {
+			print_error("Checksum failed for " + data.files[i]->path);
+			checksum_failed_files.push_back(data.files[i]->get_path());
+			checksum_failed = true;
+		} else if (results[i] != OK && err == OK) {
+			err = results[i];
 		}
-		fa->flush();
-		print_line("Extracted " + target_name);
+		// Files that failed are extracted again by the next run
+		String md5 = _get_md5_string(data.files[i]->pf.md5);
+		if (results[i] == OK && !md5.is_empty()) {
+			new_entries[data.files[i]->get_path()] = md5;
+		}
+		if (!errors[i].is_empty()) {
+			failed_files += data.files[i]->get_path() + " (" + errors[i] + ")\n";
+			continue;
+		}
+		extracted_files.push_back(data.files[i]->get_path());
+		String target_name = dir.plus_file(data.files[i]->get_path().replace("res://", ""));
+		// The project config loader isn't thread safe, so it runs once everything is extracted
 		if (target_name.get_file() == "engine.cfb" || target_name.get_file() == "project.binary") {
 			ProjectConfigLoader *pcfgldr = memnew(ProjectConfigLoader);
 			uint32_t ver_major = GDRESettings::get_singleton()->get_ver_major();
@@ -93,6 +411,10 @@ Error PckDumper::pck_dump_to_dir(const String &dir) {
 			memdelete(pcfgldr);
 		}
 	}
+	print_line("Extracted " + itos(data.extracted.get()) + " of " + itos(data.files.size()) + " files");
+	if (files.size() > data.files.size()) {
+		print_line("Skipped " + itos(files.size() - data.files.size()) + " unchanged files");
+	}
 
 	if (failed_files.length() > 0) {
 		print_error("At least one error was detected while extracting pack!\n" + failed_files);
@@ -101,7 +423,15 @@ Error PckDumper::pck_dump_to_dir(const String &dir) {
 		print_line("No errors detected!");
 		//show_warning(RTR("No errors detected."), RTR("Read PCK"), RTR("The operation completed successfully!"));
 	}
-	return OK;
+	Error save_err = _save_pack_manifest(manifest_path, new_entries);
+	if (err == OK) {
+		err = save_err;
+	}
+	// Files that couldn't be read or written are the worse failure, the rest of the tree is usable after a mismatch
+	if (err == OK && checksum_failed) {
+		err = ERR_BUG;
+	}
+	return err;
 }
 
 Error PckDumper::pck_load_and_dump(const String &p_path, const String &dir) {
@@ -109,14 +439,22 @@ Error PckDumper::pck_load_and_dump(const String &p_path, const String &dir) {
 	if (result != OK) {
 		return result;
 	}
-	check_md5_all_files();
-	result = pck_dump_to_dir(dir);
-	if (result != OK) {
+	// Checksum failures are reported but don't fail the dump
+	result = pck_dump_and_verify(dir);
+	if (result != OK && result != ERR_BUG) {
 		return result;
 	}
 	return OK;
 }
 
+Vector<String> PckDumper::get_checksum_failed_files() const {
+	return checksum_failed_files;
+}
+
+Vector<String> PckDumper::get_extracted_files() const {
+	return extracted_files;
+}
+
 bool PckDumper::is_loaded() {
 	return loaded;
 }
@@ -138,6 +476,10 @@ int PckDumper::get_file_count() {
 }
 
 void PckDumper::clear_data() {
+	indexed_scripts.clear();
+	script_index.clear();
+	checksum_failed_files.clear();
+	extracted_files.clear();
 	GDRESettings::get_singleton()->unload_pack();
 }
 
@@ -152,19 +494,133 @@ Vector<String> PckDumper::get_loaded_files() {
 	return filenames;
 }
 
+void PckDumper::_index_scripts_worker(uint32_t p_worker, ScriptIndexData *p_data) {
+	GDScriptDecomp *decomp = create_decomp_for_commit(p_data->commit);
+	ERR_FAIL_COND(!decomp);
+	while (true) {
+		uint32_t i = p_data->next_file.postincrement();
+		if (i >= (uint32_t)p_data->paths.size()) {
+			break;
+		}
+		const String &path = p_data->paths[i];
+		bool encrypted = path.get_extension().to_lower() == "gde" && p_data->decrypt.is_key_set();
+		Error err = decomp->load_script_symbols(path, encrypted ? &p_data->decrypt : nullptr, p_data->symbols[i]);
+		if (err) {
+			p_data->errors[i] = decomp->get_failure_message(err);
+		}
+	}
+	memdelete(decomp);
+}
+
+Error PckDumper::build_script_index(int p_threads) {
+	indexed_scripts.clear();
+	script_index.clear();
+	ERR_FAIL_COND_V_MSG(!GDRESettings::get_singleton()->is_pack_loaded(), ERR_DOES_NOT_EXIST, "No pack loaded");
+
+	Vector<String> filters;
+	filters.push_back("*.gdc");
+	filters.push_back("*.gde");
+	Vector<Ref<PackedFileInfo>> files = GDRESettings::get_singleton()->get_file_info_list(filters);
+	if (files.is_empty()) {
+		return OK;
+	}
+
+	ScriptIndexData data;
+	for (int i = 0; i < files.size(); i++) {
+		data.paths.push_back(files[i]->get_path());
+	}
+	Vector<GDScriptDecomp::VersionScore> detected = GDScriptDecomp::detect_version_from_files(data.paths);
+	if (detected.size() > 0) {
+		data.commit = detected[0].commit;
+	} else {
+		GDScriptDecomp *decomp = GDScriptDecomp::create(get_engine_version());
+		ERR_FAIL_COND_V_MSG(!decomp, ERR_UNAVAILABLE, "Can't determine the bytecode version of the scripts.");
+		data.commit = decomp->get_commit();
+		memdelete(decomp);
+	}
+	Vector<uint8_t> key = get_key();
+	if (key.size() == 32) {
+		data.decrypt.set_key(key);
+	}
+
+	Vector<Vector<String>> symbols;
+	symbols.resize(data.paths.size());
+	data.symbols = symbols.ptrw();
+	Vector<String> errors;
+	errors.resize(data.paths.size());
+	data.errors = errors.ptrw();
+
+	int threads = p_threads > 0 ? p_threads : WorkerThreadPool::get_singleton()->get_thread_count();
+	threads = CLAMP(threads, 1, data.paths.size());
+	WorkerThreadPool::GroupID group_id = WorkerThreadPool::get_singleton()->add_template_group_task(this, &PckDumper::_index_scripts_worker, &data, threads, threads, true, "PckDumper::build_script_index");
+	WorkerThreadPool::get_singleton()->wait_for_group_task_completion(group_id);
+
+	// Merged in pack order, so a script already added for a symbol is always the last one in its list
+	String failed_files;
+	indexed_scripts = data.paths;
+	for (int i = 0; i < symbols.size(); i++) {
+		if (!errors[i].is_empty()) {
+			failed_files += data.paths[i] + " (" + errors[i] + ")\n";
+			continue;
+		}
+		const Vector<String> &script_symbols = symbols[i];
+		for (int j = 0; j < script_symbols.size(); j++) {
+			HashMap<String, LocalVector<uint32_t>>::Iterator E = script_index.find(script_symbols[j]);
+			if (!E) {
+				E = script_index.insert(script_symbols[j], LocalVector<uint32_t>());
+			}
+			if (E->value.is_empty() || E->value[E->value.size() - 1] != (uint32_t)i) {
+				E->value.push_back(i);
+			}
+		}
+	}
+
+	if (failed_files.length() > 0) {
+		print_error("At least one script could not be indexed!\n" + failed_files);
+		return ERR_INVALID_DATA;
+	}
+	return OK;
+}
+
+bool PckDumper::has_script_index() const {
+	return !indexed_scripts.is_empty();
+}
+
+Vector<String> PckDumper::find_scripts_with_symbol(const String &p_symbol) const {
+	Vector<String> ret;
+	HashMap<String, LocalVector<uint32_t>>::ConstIterator E = script_index.find(p_symbol);
+	if (E) {
+		for (uint32_t i = 0; i < E->value.size(); i++) {
+			ret.push_back(indexed_scripts[E->value[i]]);
+		}
+	}
+	return ret;
+}
+
 String PckDumper::get_engine_version() {
 	return GDRESettings::get_singleton()->get_version_string();
 }
 
 void PckDumper::_bind_methods() {
 	ClassDB::bind_method(D_METHOD("load_pck"), &PckDumper::load_pck);
-	ClassDB::bind_method(D_METHOD("check_md5_all_files"), &PckDumper::check_md5_all_files);
-	ClassDB::bind_method(D_METHOD("pck_dump_to_dir"), &PckDumper::pck_dump_to_dir);
+	ClassDB::bind_method(D_METHOD("check_md5_all_files", "threads"), &PckDumper::check_md5_all_files, DEFVAL(-1));
+	ClassDB::bind_method(D_METHOD("pck_dump_to_dir", "dir", "threads"), &PckDumper::pck_dump_to_dir, DEFVAL(-1));
+	ClassDB::bind_method(D_METHOD("pck_dump_and_verify", "dir", "fail_action", "threads"), &PckDumper::pck_dump_and_verify, DEFVAL(CHECKSUM_FAIL_KEEP), DEFVAL(-1));
+	ClassDB::bind_method(D_METHOD("pck_dump_incremental", "dir", "fail_action", "threads"), &PckDumper::pck_dump_incremental, DEFVAL(CHECKSUM_FAIL_KEEP), DEFVAL(-1));
 	ClassDB::bind_method(D_METHOD("pck_load_and_dump"), &PckDumper::pck_load_and_dump);
+	ClassDB::bind_method(D_METHOD("get_checksum_failed_files"), &PckDumper::get_checksum_failed_files);
+	ClassDB::bind_method(D_METHOD("get_extracted_files"), &PckDumper::get_extracted_files);
 	ClassDB::bind_method(D_METHOD("is_loaded"), &PckDumper::is_loaded);
 	ClassDB::bind_method(D_METHOD("get_file_count"), &PckDumper::get_file_count);
 	ClassDB::bind_method(D_METHOD("get_loaded_files"), &PckDumper::get_loaded_files);
 	ClassDB::bind_method(D_METHOD("get_engine_version"), &PckDumper::get_engine_version);
 	ClassDB::bind_method(D_METHOD("clear_data"), &PckDumper::clear_data);
+	ClassDB::bind_method(D_METHOD("build_script_index", "threads"), &PckDumper::build_script_index, DEFVAL(-1));
+	ClassDB::bind_method(D_METHOD("has_script_index"), &PckDumper::has_script_index);
+	ClassDB::bind_method(D_METHOD("find_scripts_with_symbol", "symbol"), &PckDumper::find_scripts_with_symbol);
 	//ClassDB::bind_method(D_METHOD("get_dumped_files"), &PckDumper::get_dumped_files);
+
+	BIND_ENUM_CONSTANT(CHECKSUM_FAIL_KEEP);
+	BIND_ENUM_CONSTANT(CHECKSUM_FAIL_DELETE);
+	BIND_ENUM_CONSTANT(CHECKSUM_FAIL_QUARANTINE);
 }
@@ -7,8 +7,12 @@
 #include "core/io/resource_importer.h"
 #include "core/object/object.h"
 #include "core/object/ref_counted.h"
+#include "core/templates/hash_map.h"
+#include "core/templates/local_vector.h"
 #include "core/templates/rb_map.h"
+#include "core/templates/safe_refcount.h"
 
+#include "bytecode/bytecode_base.h"
 #include "gdre_packed_data.h"
 
 class PckDumper : public RefCounted {
@@ -18,7 +22,69 @@ class PckDumper : public RefCounted {
 	bool should_check_md5 = false;
 	bool loaded = false;
 	bool _get_magic_number(Ref<FileAccess> pck);
-	bool _pck_file_check_md5(Ref<PackedFileInfo> &file);
+	bool _pck_file_check_md5(const Ref<PackedFileInfo> &file);
+
+	enum {
+		MD5_SMALL_FILE_SIZE = 64 * 1024, // hashed in groups by MD5MultiBuffer
+	};
+	struct MD5CheckData {
+		Vector<Ref<PackedFileInfo>> files;
+		// Large files first, biggest to smallest, then small files in groups of similar size
+		LocalVector<uint32_t> order;
+		uint32_t large_count = 0;
+		uint32_t job_count = 0;
+		SafeNumeric<uint32_t> next_job;
+	};
+	void _check_md5_worker(uint32_t p_worker, MD5CheckData *p_data);
+
+	struct ScriptIndexData {
+		uint64_t commit = 0;
+		Vector<String> paths;
+		GDScriptDecryptContext decrypt; // shared by all workers
+		Vector<String> *symbols = nullptr;
+		String *errors = nullptr;
+		SafeNumeric<uint32_t> next_file;
+	};
+	void _index_scripts_worker(uint32_t p_worker, ScriptIndexData *p_data);
+
+public:
+	// What happens to an extracted file whose checksum doesn't match
+	enum ChecksumFailAction {
+		CHECKSUM_FAIL_KEEP,
+		CHECKSUM_FAIL_DELETE,
+		CHECKSUM_FAIL_QUARANTINE, // moved below QUARANTINE_DIR in the output directory
+	};
+
+private:
+	struct ExtractData {
+		String dir;
+		Vector<Ref<PackedFileInfo>> files;
+		bool verify = false;
+		ChecksumFailAction fail_action = CHECKSUM_FAIL_KEEP;
+		String *errors = nullptr;
+		// OK, the I/O error of the file, or ERR_BUG when its checksum was computed and didn't match
+		Error *results = nullptr;
+		SafeNumeric<uint32_t> next_file;
+		SafeNumeric<uint32_t> extracted;
+	};
+	void _extract_files_worker(uint32_t p_worker, ExtractData *p_data);
+	Error _pck_dump_to_dir(const String &dir, int p_threads, bool p_verify, ChecksumFailAction p_fail_action, bool p_incremental);
+
+	// Path -> MD5 of every file a dump extracted, kept in the output directory
+	enum {
+		PACK_MANIFEST_FORMAT_VERSION = 1,
+	};
+	static Error _load_pack_manifest(const String &p_path, HashMap<String, String> &r_entries);
+	static Error _save_pack_manifest(const String &p_path, const HashMap<String, String> &p_entries);
+
+	// Files of the last verified dump whose MD5 didn't match
+	Vector<String> checksum_failed_files;
+	// Files the last dump wrote and left at their place, skipped and set aside files aren't listed
+	Vector<String> extracted_files;
+
+	// Symbol -> indices into indexed_scripts, in pack order
+	Vector<String> indexed_scripts;
+	HashMap<String, LocalVector<uint32_t>> script_index;
 
 protected:
 	static void _bind_methods();
@@ -31,14 +97,33 @@ public:
 	Ref<FileAccess> get_file_access(const String &p_path, PackedFileInfo *p_file);
 
 	Error load_pck(const String &p_path);
-	Error check_md5_all_files();
+	Error check_md5_all_files(int p_threads = -1);
 	Error pck_dump_to_dir2(const String &dir);
-	Error pck_dump_to_dir(const String &dir);
+	static const char *QUARANTINE_DIR;
+	static const char *PACK_MANIFEST_FILE;
+
+	// Directories are created first, then the files are written by p_threads workers.
+	// Returns the error of the first file that couldn't be read or written.
+	Error pck_dump_to_dir(const String &dir, int p_threads = -1);
+	// Same as pck_dump_to_dir(), the MD5 of each file is computed from the bytes being written.
+	// ERR_BUG when every file was written but some checksums didn't match.
+	Error pck_dump_and_verify(const String &dir, ChecksumFailAction p_fail_action = CHECKSUM_FAIL_KEEP, int p_threads = -1);
+	// Same as pck_dump_and_verify(), files whose MD5 matches the last dump to dir aren't extracted again
+	Error pck_dump_incremental(const String &dir, ChecksumFailAction p_fail_action = CHECKSUM_FAIL_KEEP, int p_threads = -1);
 	Error pck_load_and_dump(const String &p_path, const String &dir);
+	Vector<String> get_checksum_failed_files() const;
+	Vector<String> get_extracted_files() const;
 	bool is_loaded();
 	String get_engine_version();
 	int get_file_count();
 	Vector<String> get_loaded_files();
+
+	// Identifiers and string constants (resource paths, signal names...) of every script in the pack
+	Error build_script_index(int p_threads = -1);
+	bool has_script_index() const;
+	Vector<String> find_scripts_with_symbol(const String &p_symbol) const;
 };
 
+VARIANT_ENUM_CAST(PckDumper::ChecksumFailAction);
+
 #endif //RE_PCK_DUMPER_H